@@ -0,0 +1,189 @@
+// End-to-end benchmark of the trap-space pipeline on generated networks. Every phase
+// is timed on its own at increasing sizes and the results are written as JSON.
+// Usage: ailp_bench [output.json] [max_nodes] [seed]
+// Built with AILP_INSTRUMENTATION it also writes <output>.trace.json (Chrome trace
+// events) and <output>.phases.json (per-phase totals and counters).
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BooleanNetwork.h"
+#include "ILPModelBuilder.h"
+#include "Instrumentation.h"
+#include "IncludingSolutions.h"
+#include "PipelinedAnalysis.h"
+#include "Percolation.h"
+#include "Reachability.h"
+#include "SolutionObjects.h"
+#include "network_generator.h"
+
+using namespace std;
+
+namespace {
+
+struct BenchResult {
+    string family;
+    int nodes = 0;
+    int externals = 0;
+    uint64_t seed = 0;
+    int state_size = 0;
+    int threshold_rows = 0;
+    int trap_spaces = 0;
+    int reachability_checks = 0;
+    int remaining_solutions = 0;
+    vector<pair<string, double>> phases;   // in pipeline order
+};
+
+void time_phase(BenchResult& result, const string& phase, const function<void()>& body) {
+    auto start = chrono::steady_clock::now();
+    body();
+    result.phases.emplace_back(phase, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+}
+
+BenchResult run(NetworkFamily family, int nodes, int k, uint64_t seed) {
+    BenchResult result;
+    result.family = network_family_name(family);
+    result.nodes = nodes;
+    result.externals = max(1, nodes / 16);
+    result.seed = seed;
+
+    string path = (filesystem::temp_directory_path()
+                   / ("ailp_bench_" + result.family + "_" + to_string(nodes) + "_" + to_string(seed) + ".txt")).string();
+    write_network(path, generate_network(family, nodes, result.externals, k, seed));
+
+    BooleanNetwork network;
+    time_phase(result, "parse", [&] { network.parse(path); });
+    time_phase(result, "updated_network", [&] { network.updated_network(); });
+    time_phase(result, "threshold_synthesis", [&] {
+        network.synthesize_threshold_functions();
+        network.get_threshold_functions();
+        network.compute_unateness();
+    });
+    result.state_size = network.state_size;
+    for (const auto& [id, functions] : network.threshold_functions) result.threshold_rows += functions.size();
+
+    // One external context for the whole run, as SpecialNodes would hand out for a
+    // fully fixed environment
+    mt19937_64 rng(seed);
+    vector<int> external_values(network.external_size);
+    enumeration_options.fixed_externals.clear();
+    for (int e = 0; e < network.external_size; ++e) {
+        external_values[e] = rng() & 1;
+        enumeration_options.fixed_externals[e] = external_values[e];
+    }
+
+    PercolationResult percolation;
+    time_phase(result, "percolation", [&] {
+        percolation = percolate_constants(network, enumeration_options.fixed_externals);
+    });
+    time_phase(result, "build_ilp_model", [&] {
+        if (percolation.free_states.empty()) return;
+        build_ilp_model(network, percolation.free_states.size(), percolation);
+    });
+
+    SolutionObjects solutions;
+    time_phase(result, "enumeration", [&] { solutions = find_stable_states(network); });
+    for (const auto& [id, solution] : solutions.solutions) {
+        int external_id = solutions.add_externals_assignments({external_values});
+        solutions.update_external_to_solution(id, external_id);
+    }
+    result.trap_spaces = solutions.solutions.size();
+
+    // Only the checks themselves are timed; building the reduced systems is part of
+    // remove_included_solutions below
+    SolutionObjects hierarchy = solutions;
+    build_solutions_hierarchy_tree(network, hierarchy);
+    double reachability_seconds = 0;
+    for (const auto& [id, included_ids] : hierarchy.all_included_solutions) {
+        if (included_ids.empty()) continue;
+        vector<TrapSpace> included;
+        for (int i : included_ids) included.push_back(hierarchy.solutions.at(i));
+        const TrapSpace& solution = hierarchy.solutions.at(id);
+        auto system = get_reduced_threshold_functions(network, solution.stable_nodes, external_values, included);
+        auto start = chrono::steady_clock::now();
+        check_if_reachable(solution, included, system);
+        reachability_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        result.reachability_checks++;
+    }
+    result.phases.emplace_back("check_if_reachable", reachability_seconds);
+
+    SolutionObjects pruned = solutions;
+    time_phase(result, "remove_included_solutions", [&] {
+        remove_included_solutions(network, pruned, true);
+    });
+    result.remaining_solutions = pruned.solutions.size();
+
+    // The same three phases overlapped
+    time_phase(result, "pipelined", [&] {
+        auto assign_externals = [&external_values](const map<int, int>& stable_states) {
+            SolutionObjects space;
+            int id = space.add_solution(stable_states);
+            space.update_external_to_solution(id, space.add_externals_assignments({external_values}));
+            return space;
+        };
+        find_and_prune_pipelined(network, assign_externals, true);
+    });
+
+    filesystem::remove(path);
+    return result;
+}
+
+void write_json(ostream& out, const vector<BenchResult>& results) {
+    out << "{\n  \"benchmark\": \"ailp\",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"family\": \"" << r.family << "\", \"nodes\": " << r.nodes
+            << ", \"externals\": " << r.externals << ", \"seed\": " << r.seed
+            << ", \"state_size\": " << r.state_size << ", \"threshold_rows\": " << r.threshold_rows
+            << ", \"trap_spaces\": " << r.trap_spaces
+            << ", \"reachability_checks\": " << r.reachability_checks
+            << ", \"remaining_solutions\": " << r.remaining_solutions
+            << ",\n     \"seconds\": {";
+        for (size_t p = 0; p < r.phases.size(); ++p) {
+            out << (p ? ", " : "") << "\"" << r.phases[p].first << "\": " << r.phases[p].second;
+        }
+        out << "}}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    string output = argc > 1 ? argv[1] : "ailp_bench.json";
+    int max_nodes = argc > 2 ? atoi(argv[2]) : 64;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+    const vector<pair<NetworkFamily, int>> families = {
+        {NetworkFamily::NK, 2},
+        {NetworkFamily::ScaleFree, 3},
+        {NetworkFamily::Layered, 2},
+    };
+
+    vector<BenchResult> results;
+    for (int n = 8; n <= max_nodes; n *= 2) {
+        for (const auto& [family, k] : families) {
+            results.push_back(run(family, n, k, seed + n));
+            const auto& r = results.back();
+            cerr << r.family << " n=" << r.nodes;
+            for (const auto& [phase, seconds] : r.phases) cerr << " " << phase << "=" << seconds;
+            cerr << endl;
+        }
+    }
+
+    ofstream out(output);
+    write_json(out, results);
+    cerr << "wrote " << output << endl;
+    if (write_chrome_trace(output + ".trace.json") && write_trace_summary(output + ".phases.json")) {
+        cerr << "wrote " << output << ".trace.json and " << output << ".phases.json" << endl;
+    }
+    return out ? 0 : 1;
+}
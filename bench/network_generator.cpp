@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "network_generator.h"
+
+using namespace std;
+
+namespace {
+
+// rng() % n rather than a distribution object, so the output does not depend on the
+// standard library implementation.
+int pick(mt19937_64& rng, int n) {
+    return static_cast<int>(rng() % static_cast<uint64_t>(n));
+}
+
+string input_name(int input, int nodes) {
+    return input < nodes ? "x" + to_string(input) : "u" + to_string(input - nodes);
+}
+
+// Distinct inputs drawn with the given weights (all zero weights mean uniform).
+vector<int> pick_inputs(mt19937_64& rng, const vector<long long>& weights, int k) {
+    vector<int> inputs;
+    vector<long long> w = weights;
+    k = min<int>(k, w.size());
+    for (int j = 0; j < k; ++j) {
+        long long total = 0;
+        for (long long x : w) total += x;
+        if (total == 0) break;
+        long long r = static_cast<long long>(rng() % static_cast<uint64_t>(total));
+        int chosen = 0;
+        while (r >= w[chosen]) r -= w[chosen++];
+        inputs.push_back(chosen);
+        w[chosen] = 0;
+    }
+    sort(inputs.begin(), inputs.end());
+    return inputs;
+}
+
+// Random truth table over the inputs that is non-constant and, when a few retries
+// allow it, reads every input.
+vector<bool> random_truth_table(mt19937_64& rng, int num_inputs) {
+    const int rows = 1 << num_inputs;
+    vector<bool> table(rows);
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        int ones = 0;
+        for (int m = 0; m < rows; ++m) {
+            table[m] = rng() & 1;
+            ones += table[m];
+        }
+        if (ones == 0 || ones == rows) continue;
+
+        bool all_essential = true;
+        for (int j = 0; j < num_inputs && all_essential; ++j) {
+            bool essential = false;
+            for (int m = 0; m < rows && !essential; ++m) {
+                essential = table[m] != table[m ^ (1 << j)];
+            }
+            all_essential = essential;
+        }
+        if (all_essential) return table;
+    }
+    // Fall back to the first input, which is never constant
+    for (int m = 0; m < rows; ++m) table[m] = m & 1;
+    return table;
+}
+
+// Sum of the true minterms, or the complement of the false ones when that is shorter.
+string render_truth_table(const vector<bool>& table, const vector<string>& names) {
+    const int rows = table.size();
+    int ones = count(table.begin(), table.end(), true);
+    bool complement = ones > rows / 2;
+
+    ostringstream out;
+    if (complement) out << "~(";
+    bool first = true;
+    for (int m = 0; m < rows; ++m) {
+        if (table[m] == complement) continue;
+        if (!first) out << " | ";
+        first = false;
+        out << "(";
+        for (size_t j = 0; j < names.size(); ++j) {
+            if (j) out << " & ";
+            if (!((m >> j) & 1)) out << "~";
+            out << names[j];
+        }
+        out << ")";
+    }
+    if (complement) out << ")";
+    return out.str();
+}
+
+}
+
+const char* network_family_name(NetworkFamily family) {
+    switch (family) {
+        case NetworkFamily::NK: return "nk";
+        case NetworkFamily::ScaleFree: return "scale_free";
+        case NetworkFamily::Layered: return "layered";
+    }
+    return "unknown";
+}
+
+string generate_network(NetworkFamily family, int nodes, int externals, int k, uint64_t seed) {
+    mt19937_64 rng(seed);
+    const int inputs = nodes + externals;
+    vector<vector<int>> regulators(nodes);
+
+    if (family == NetworkFamily::NK) {
+        for (int v = 0; v < nodes; ++v) {
+            regulators[v] = pick_inputs(rng, vector<long long>(inputs, 1), k);
+        }
+    } else if (family == NetworkFamily::ScaleFree) {
+        // Weight out-degree + 1; targets are visited in a shuffled order so early ids do
+        // not become the hubs by construction.
+        vector<long long> out_degree(inputs, 1);
+        vector<int> order(nodes);
+        for (int v = 0; v < nodes; ++v) order[v] = v;
+        for (int i = nodes - 1; i > 0; --i) swap(order[i], order[pick(rng, i + 1)]);
+        for (int v : order) {
+            int in_degree = 1 + pick(rng, k);
+            regulators[v] = pick_inputs(rng, out_degree, in_degree);
+            for (int p : regulators[v]) out_degree[p]++;
+        }
+    } else {
+        int width = max(k, static_cast<int>(sqrt(static_cast<double>(nodes))));
+        int layers = (nodes + width - 1) / width;
+        for (int v = 0; v < nodes; ++v) {
+            int layer = v / width;
+            int from = layer == 0 ? (layers - 1) * width : (layer - 1) * width;
+            int to = layer == 0 ? nodes : layer * width;
+            vector<long long> weights(inputs, 0);
+            for (int p = from; p < to; ++p) weights[p] = 1;
+            // The first layer also reads the externals
+            if (layer == 0) {
+                for (int e = nodes; e < inputs; ++e) weights[e] = 1;
+            }
+            regulators[v] = pick_inputs(rng, weights, k);
+        }
+    }
+
+    ostringstream rules;
+    for (int v = 0; v < nodes; ++v) {
+        vector<string> names;
+        for (int p : regulators[v]) names.push_back(input_name(p, nodes));
+        if (names.empty()) names.push_back(input_name(v, nodes));
+        rules << input_name(v, nodes) << "*=" << render_truth_table(random_truth_table(rng, names.size()), names)
+              << "\n";
+    }
+    for (int e = 0; e < externals; ++e) {
+        rules << input_name(nodes + e, nodes) << "*=" << input_name(nodes + e, nodes) << "\n";
+    }
+    return rules.str();
+}
+
+bool write_network(const string& path, const string& rules) {
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    out << rules;
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,24 @@
+#ifndef NETWORK_GENERATOR_H
+#define NETWORK_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+// Random regulatory network families for benchmarking:
+//   NK         - every node reads k random nodes through a random truth table;
+//   ScaleFree  - regulators picked by preferential attachment, so out-degrees follow a
+//                power law while in-degrees stay at most k;
+//   Layered    - nodes read k nodes of the previous layer, and the first layer reads
+//                the last one, closing long feedback loops.
+enum class NetworkFamily { NK, ScaleFree, Layered };
+
+const char* network_family_name(NetworkFamily family);
+
+// Rules in the `name*=expression` format read by parseExpressions, using &, | and ~.
+// State nodes are x0..x{nodes-1}, externals u0..u{externals-1} (`u*=u`). Every function
+// is non-constant and reads at most k inputs; the same seed always gives the same text.
+std::string generate_network(NetworkFamily family, int nodes, int externals, int k, uint64_t seed);
+
+bool write_network(const std::string& path, const std::string& rules);
+
+#endif // NETWORK_GENERATOR_H
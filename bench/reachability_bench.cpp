@@ -0,0 +1,88 @@
+// Microbenchmark for the explicit reachability kernels on random threshold systems.
+// Usage: reachability_bench [max_states] [threads]
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "ReachabilityKernel.h"
+
+using namespace std;
+
+namespace {
+
+ExplorationSystem random_system(int n, int regulators, mt19937& rng) {
+    ExplorationSystem system;
+    system.num_vars = n;
+    system.row_begin.push_back(0);
+
+    uniform_int_distribution<int> node(0, n - 1);
+    uniform_int_distribution<int> weight(1, 2);
+    bernoulli_distribution inhibitory(0.3);
+
+    for (int v = 0; v < n; ++v) {
+        vector<int> row(n, 0);
+        int positive = 0;
+        for (int k = 0; k < regulators; ++k) {
+            int w = weight(rng);
+            if (inhibitory(rng)) {
+                w = -w;
+            } else {
+                positive += w;
+            }
+            row[node(rng)] = w;
+        }
+        system.weights.insert(system.weights.end(), row.begin(), row.end());
+        system.thresholds.push_back(max(1, positive / 2));
+        system.row_begin.push_back(system.thresholds.size());
+        int self = system.row(v)[v];
+        system.self_unateness.push_back(self > 0 ? 1 : self < 0 ? -1 : 2);
+    }
+    return system;
+}
+
+void run(const string& kernel, int n, uint64_t max_states,
+         const function<long long()>& explore) {
+    auto start = chrono::steady_clock::now();
+    long long unreachable = explore();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t states = unreachable < 0 ? max_states : (uint64_t(1) << n) - unreachable;
+    cout << "n=" << n << " kernel=" << kernel
+         << " states=" << states
+         << " seconds=" << seconds
+         << " states_per_sec=" << (seconds > 0 ? states / seconds : 0) << endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    uint64_t max_states = argc > 1 ? strtoull(argv[1], nullptr, 10) : (uint64_t(1) << 20);
+    int threads = argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+
+    for (int n : {16, 20, 24}) {
+        mt19937 rng(n);
+        ExplorationSystem system = random_system(n, 3, rng);
+
+        // Target a single cube fixing a quarter of the nodes.
+        vector<int> cube(n, -1);
+        for (int v = 0; v < n / 4; ++v) cube[v] = rng() & 1;
+        vector<vector<int>> initial_cubes = {cube};
+
+        run("full_recompute", n, max_states, [&] {
+            return count_unreachable_states_full_recompute(system, initial_cubes, max_states);
+        });
+        run("incremental", n, max_states, [&] {
+            return count_unreachable_states(system, initial_cubes, max_states);
+        });
+        run("batched", n, max_states, [&] {
+            return count_unreachable_states_batched(system, initial_cubes, max_states);
+        });
+        run("parallel", n, max_states, [&] {
+            return count_unreachable_states_parallel(system, initial_cubes, threads, max_states);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef ANALYSIS_DAEMON_H
+#define ANALYSIS_DAEMON_H
+
+#include <string>
+#include <vector>
+
+#include "AnalysisSession.h"
+
+// Line protocol of the analysis daemon. A client sends a batch of request lines
+// ended by an empty line and gets one response line per request, in order, followed
+// by an empty line. Nodes are referred to by name; a space or assignment is
+// `name=0,name=1,...` or `-` when empty.
+//
+//   PING                                   -> OK
+//   TRAP_SPACES <externals> [minimal]      -> OK <count> <space>;<space>;...
+//   REACH <from> <to>|<to>... <externals>  -> OK <states of from that cannot reach to, -1 if abandoned>
+//   INCLUDED <from> <inner> <externals>    -> OK 1 | OK 0
+//   SHUTDOWN                               -> OK, then the daemon exits after the batch
+//
+// Externals not listed in a REACH or INCLUDED request are 0. Errors are answered with
+// `ERR <message>` and do not affect the rest of the batch.
+
+// Answers one request line.
+std::string handle_request(AnalysisSession& session, const std::string& line);
+
+// Answers a batch; repeated lines are only evaluated once.
+std::vector<std::string> handle_batch(AnalysisSession& session, const std::vector<std::string>& lines);
+
+// Serves the session on a Unix domain socket until a SHUTDOWN request. Connections
+// are handled one at a time, since the session is not thread-safe. Returns non-zero
+// when the socket cannot be set up (a file other than a stale socket is in the way) or
+// accepting connections fails for good.
+int run_daemon(AnalysisSession& session, const std::string& socket_path);
+
+#endif // ANALYSIS_DAEMON_H
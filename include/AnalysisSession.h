@@ -0,0 +1,53 @@
+#ifndef ANALYSIS_SESSION_H
+#define ANALYSIS_SESSION_H
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "BooleanNetwork.h"
+#include "ILPModelBuilder.h"
+#include "Percolation.h"
+
+// A network loaded once (parsed, reduced, thresholds synthesized) that answers
+// repeated queries. Percolation results, trap spaces and reachability answers are
+// cached per query, so asking the same question again is a lookup. Not thread-safe:
+// queries run the enumeration under the global enumeration_options.
+class AnalysisSession {
+public:
+    explicit AnalysisSession(const std::string& rules_path);
+
+    BooleanNetwork& get_network() { return network; }
+
+    // Trap spaces (node id -> value, forced nodes included) with the given externals
+    // fixed (external index -> value), largest first.
+    const std::vector<std::map<int, int>>& trap_spaces(const std::map<int, int>& fixed_externals,
+                                                       bool minimal_only = false);
+
+    // Number of states of the trap space `from` that cannot reach any of the subspaces
+    // in `to` under the external assignment (one value per external); -1 when the
+    // check was abandoned. 0 means `from` only leads into `to`.
+    int count_unreachable(const std::map<int, int>& from,
+                          const std::vector<std::map<int, int>>& to,
+                          const std::vector<int>& externals);
+
+    // `inner` fixes every node `from` fixes, to the same value, and every state of
+    // `from` reaches it: the test remove_included_solutions applies to drop `from`.
+    bool is_included(const std::map<int, int>& from,
+                     const std::map<int, int>& inner,
+                     const std::vector<int>& externals);
+
+    void clear_cache();
+
+private:
+    const PercolationResult& percolation(const std::map<int, int>& fixed_externals);
+
+    BooleanNetwork network;
+    std::map<std::map<int, int>, PercolationResult> percolation_cache;
+    std::map<std::pair<std::map<int, int>, bool>, std::vector<std::map<int, int>>> trap_space_cache;
+    std::map<std::tuple<std::map<int, int>, std::vector<std::map<int, int>>, std::vector<int>>, int> reachability_cache;
+};
+
+#endif // ANALYSIS_SESSION_H
@@ -9,11 +9,24 @@
 #include "Node.h"
 
 using ThresholdFunction = std::pair<std::vector<int>, int>;
+// Node is on iff every row [weights . x >= threshold] holds.
+using ThresholdFunctions = std::vector<ThresholdFunction>;
 class BooleanNetwork {
 public:
     explicit BooleanNetwork(const std::string& network_name, const std::string& path = "");
+    // Empty network for running the construction phases one at a time: parse,
+    // updated_network, synthesize_threshold_functions, get_threshold_functions and
+    // compute_unateness, in that order.
+    BooleanNetwork() = default;
 
-    std::unordered_map<int, ThresholdFunction> get_threshold_functions();
+    bool parse(const std::string& network_name);
+    void updated_network();
+
+    std::unordered_map<int, ThresholdFunctions> get_threshold_functions();
+    void synthesize_threshold_functions(int max_threshold_order = 4);
+    // Only the named state nodes; every other node keeps the rows it already has.
+    void synthesize_threshold_functions(const std::unordered_set<std::string>& node_names,
+                                        int max_threshold_order = 4);
     void display_network_threshold_function();
     int get_state_size() const;
 
@@ -33,23 +46,19 @@ public:
     std::vector<std::string> get_updated_successors_for_node(const std::string& name) const;
     std::unordered_map<std::string, std::shared_ptr<Node>> nodes;
 
-    std::unordered_map<int, ThresholdFunction> threshold_functions;
+    std::unordered_map<int, ThresholdFunctions> threshold_functions;
+
+    // Node id -> {"positive", "negative", "binate"} -> input ids (irrelevant inputs are
+    // not listed), filled by compute_unateness from the threshold functions.
+    std::unordered_map<int, std::unordered_map<std::string, std::vector<int>>> unate_dict;
+    void compute_unateness();
 
 private:
-    void updated_network();
     void delete_not_influence_nodes();
     std::vector<std::string> delete_external_only_depended();
     std::vector<std::string> delete_hole_nodes();
 
      // Placeholder – actual serialization not implemented
-
-
-
-
-
-
-
-    std::unordered_map<int, std::unordered_map<std::string, std::vector<int>>> unate_dict;
 };
 
 #endif
@@ -0,0 +1,63 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Blocking FIFO between two pipeline stages. push waits while the queue is full, so a
+// fast producer cannot run ahead of its consumer by more than capacity items. After
+// close, push refuses new items and pop drains what is left, then returns nullopt.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        not_full.wait(guard, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        not_empty.wait(guard, [this] { return closed || !items.empty(); });
+        if (items.empty()) return std::nullopt;
+        std::optional<T> item(std::move(items.front()));
+        items.pop_front();
+        not_full.notify_one();
+        return item;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return items.size();
+    }
+
+private:
+    const size_t capacity;
+    mutable std::mutex lock;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T> items;
+    bool closed = false;
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,50 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <cstddef>
+
+// Time and memory budget of one find_stable_states_and_external run. Enumeration may
+// use enumeration_share of the time; the inclusion checks get the rest plus whatever
+// the enumeration leaves. When the budget runs out the run stops gracefully: the
+// solver gets per-solve time limits, the explicit reachability search abandons its
+// check, and the trap spaces found so far are returned with their verification status.
+struct BudgetOptions {
+    double time_seconds = 0;        // 0 = unlimited
+    size_t memory_bytes = 0;        // current resident set size, 0 = unlimited
+    double enumeration_share = 0.6;
+};
+
+inline BudgetOptions budget_options;
+
+enum class BudgetPhase { Enumeration, Inclusion };
+
+// Starts the clock and clears the cut flags. Until then, and after stop_budget, nothing
+// is ever exhausted.
+void start_budget();
+void stop_budget();
+
+// Seconds this thread may still spend on the phase: the phase's remaining share,
+// capped by the current BudgetStep. Infinity without a time budget.
+double budget_time_left(BudgetPhase phase);
+
+// No time left for the phase (or the current step), or resident memory above the budget.
+bool budget_exhausted(BudgetPhase phase);
+
+// Records that the phase was cut short by the budget.
+void note_budget_cut(BudgetPhase phase);
+bool budget_cut(BudgetPhase phase);
+
+// Gives the calling thread an even share of what is left of the phase, split over
+// steps_left steps, until it goes out of scope.
+class BudgetStep {
+public:
+    BudgetStep(BudgetPhase phase, int steps_left);
+    ~BudgetStep();
+    BudgetStep(const BudgetStep&) = delete;
+    BudgetStep& operator=(const BudgetStep&) = delete;
+
+private:
+    double previous_end;
+};
+
+#endif // BUDGET_H
@@ -0,0 +1,26 @@
+#ifndef CHECK_ARENA_H
+#define CHECK_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+// Scratch memory of one reachability/inclusion check. The intermediate structures of
+// the check allocate from a monotonic buffer and are all dropped at once when the arena
+// goes out of scope. The first block belongs to the thread and is reused by its next
+// check; an arena opened while another is alive on the same thread gets its own.
+class CheckArena {
+public:
+    explicit CheckArena(size_t initial_bytes = size_t(1) << 18);
+    ~CheckArena();
+    CheckArena(const CheckArena&) = delete;
+    CheckArena& operator=(const CheckArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*buffer; }
+
+private:
+    bool owns_thread_block;
+    std::optional<std::pmr::monotonic_buffer_resource> buffer;
+};
+
+#endif // CHECK_ARENA_H
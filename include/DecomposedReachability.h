@@ -0,0 +1,23 @@
+#ifndef DECOMPOSED_REACHABILITY_H
+#define DECOMPOSED_REACHABILITY_H
+
+#include <vector>
+
+#include "Reachability.h"
+
+// Strongly connected components of the explored dependency graph (v depends on i when
+// a row of v has a non-zero weight on i), upstream components first.
+std::vector<std::vector<int>> get_topological_components(const ExplorationSystem& system);
+
+// Sufficient check that every state reaches an initial cube, done component by
+// component. For a cube c, components are visited in topological order; every
+// component that c constrains must reach c's projection from all of its states, for
+// every assignment of its upstream inputs that agrees with c. Asynchronous updates
+// let each component be driven into c and then left untouched while the components
+// downstream of it move, so passing all of them proves inclusion.
+// Returns 0 when inclusion is proven and -1 when the decomposition cannot decide it.
+int decomposed_check_if_reachable(const ExplorationSystem& system,
+                                  const std::vector<std::vector<int>>& initial_cubes,
+                                  const ReachabilityOptions& options);
+
+#endif // DECOMPOSED_REACHABILITY_H
@@ -0,0 +1,46 @@
+#ifndef FEEDBACK_VERTEX_SET_H
+#define FEEDBACK_VERTEX_SET_H
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "BooleanNetwork.h"
+#include "Percolation.h"
+
+// Greedy feedback vertex set of the dependency graph restricted to `nodes`: nodes
+// that cannot lie on a cycle are peeled off repeatedly, self-loops are taken
+// directly and otherwise the node with the largest in-degree * out-degree is taken.
+std::vector<int> get_feedback_vertex_set(const BooleanNetwork& network, const std::vector<int>& nodes);
+
+// Threshold row keeping only its non-zero weights, as (network index, weight) terms.
+struct SparseThresholdRow {
+    std::vector<std::pair<int, int>> terms;
+    int threshold = 0;
+};
+using SparseThresholdFunctions = std::vector<SparseThresholdRow>;
+
+SparseThresholdFunctions to_sparse(const ThresholdFunctions& functions);
+
+// Three-valued value of node s under a partial assignment (by network index, -1 =
+// free), with the same worst cases as the ILP: 1 when every row holds for every
+// completion, 0 when some row fails for every completion, -1 otherwise.
+int evaluate_ternary(const SparseThresholdFunctions& functions, int s, const std::vector<int>& value);
+
+// Enumerates the trap spaces of the free nodes by branching only on the free externals
+// they read and on the feedback vertex set (0, 1 or free for each member); the acyclic
+// rest follows by propagation in topological order as soon as its inputs are assigned,
+// and a branch is dropped at the first member of the set it leaves inconsistent.
+// Returns false without touching trap_spaces when the worst case, branches times the
+// terms of one full propagation, exceeds max_work. Results fix at least
+// max(min_size, 1) free nodes, largest first, forced nodes included.
+bool enumerate_trap_spaces_fvs(const BooleanNetwork& network,
+                               const PercolationResult& percolation,
+                               const std::vector<int>& feedback_vertex_set,
+                               int min_size,
+                               bool minimal_only,
+                               uint64_t max_work,
+                               std::vector<std::map<int, int>>& trap_spaces);
+
+#endif // FEEDBACK_VERTEX_SET_H
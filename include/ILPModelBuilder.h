@@ -0,0 +1,140 @@
+#ifndef ILP_MODEL_BUILDER_H
+#define ILP_MODEL_BUILDER_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+#include <gurobi_c++.h>
+
+#include "BooleanNetwork.h"
+#include "SolutionObjects.h"
+#include "Percolation.h"
+#include "ModularDecomposition.h"
+#include "FeedbackVertexSet.h"
+#include "Symmetry.h"
+
+struct EnumerationOptions {
+    // External index -> value, fixed for the whole enumeration.
+    std::map<int, int> fixed_externals;
+    // Propagate constants and fixed externals before the ILP is built; forced nodes get
+    // no variables and are added back to every solution.
+    bool percolate = true;
+    // Solve the weakly connected modules of the free nodes separately, on up to
+    // `threads` threads (0 = all hardware threads), and combine them as a product.
+    bool decompose_modules = true;
+    int threads = 0;
+    // Only keep minimal trap spaces: every space found cuts all spaces containing it
+    // (under the same externals) from the smaller sizes enumerated after it.
+    bool minimal_only = false;
+    // Enumerate by branching on a feedback vertex set of the free nodes when the worst
+    // case (branches times threshold terms propagated per branch) is at most fvs_max_work;
+    // larger sets become ILP branch priorities.
+    bool use_fvs = true;
+    uint64_t fvs_max_work = uint64_t(1) << 26;
+    // Lex-leader constraints for detected node symmetries (not in minimal mode); the
+    // pruned symmetric copies are added back to the output when expand_orbits is set.
+    bool break_symmetries = true;
+    bool expand_orbits = true;
+    // Name the model's variables and constraints (`s12_0_min_3`, ...) for debugging
+    // written models; construction skips the strings otherwise.
+    bool model_names = false;
+};
+
+inline EnumerationOptions enumeration_options;
+
+// states_vars[i] and fixed_vars[i] belong to network node node_ids[i]; nodes in
+// forced_states have no variables. fixed_count is the row sum(fixed_vars) == size, whose
+// right-hand side can be moved to reuse the model for another size.
+// defining_constrs[i] is the index of the first of the three general constraints
+// (on, off, fixed) defining node_ids[i], or -1 once the node is clamped.
+// read_externals[j] is set when a free node's function reads external j.
+struct ILPModel {
+    GRBModel model;
+    std::vector<GRBVar> states_vars;
+    std::vector<GRBVar> externals_vars;
+    std::vector<GRBVar> fixed_vars;
+    std::vector<int> node_ids;
+    std::map<int, int> forced_states;
+    GRBConstr fixed_count;
+    std::vector<int> defining_constrs;
+    std::vector<bool> read_externals;
+};
+
+// Copy of the model (cuts included) in another environment, with the handles remapped
+// by index.
+ILPModel copy_ilp_model(const ILPModel& ilp_model, const GRBEnv& env);
+
+// Model of the trap spaces that fix exactly `size` of the free nodes. Variables of
+// branch_nodes get a higher branching priority. The rows of each node are built in
+// parallel for large models and handed to the solver in bulk.
+ILPModel build_ilp_model(BooleanNetwork& network, int size, const PercolationResult& percolation,
+                         const std::vector<int>& branch_nodes = {});
+
+// Holds free nodes at a value whatever their functions say (node id -> 0 for a
+// knockout, 1 for overexpression): the general constraints defining their states/fixed
+// variables are removed and the variables fixed.
+void clamp_nodes(ILPModel& ilp_model, const std::map<int, int>& values);
+
+// Every trap space of the model fixing 1..max_size of its free nodes, largest first,
+// moving the right-hand side of fixed_count instead of rebuilding.
+std::vector<std::map<int, int>> enumerate_by_size(ILPModel& ilp_model, int max_size);
+
+void add_stable_state_constraint(ILPModel& ilp_model,
+                                 const std::map<int, int>& stable_states,
+                                 bool stable_state);
+
+// Excludes every trap space that contains stable_states under external_values. Only
+// the externals the free nodes read take part: the others cannot tell two spaces apart.
+void add_subsumption_cut(ILPModel& ilp_model,
+                         const std::map<int, int>& stable_states,
+                         const std::vector<int>& external_values);
+
+std::vector<int> get_external_values(ILPModel& ilp_model);
+
+void add_symmetry_breaking_constraints(ILPModel& ilp_model, const std::vector<NodePermutation>& symmetries);
+
+// Fixed nodes of the current solution, forced nodes included.
+std::map<int, int> get_stable_states(ILPModel& ilp_model);
+
+// Receives each trap space as soon as the enumeration has settled it, in the order of
+// the returned vector.
+using TrapSpaceSink = std::function<void(const std::map<int, int>&)>;
+
+// Trap spaces fixing at least min_size of percolation.free_states, largest first.
+// With orbit expansion a size is handed to the sink once it is complete.
+std::vector<std::map<int, int>> enumerate_trap_spaces(BooleanNetwork& network,
+                                                     const PercolationResult& percolation,
+                                                     int min_size,
+                                                     const TrapSpaceSink& sink = {});
+
+// Trap spaces of each module on its own, restricted to its nodes, solved in parallel on
+// up to enumeration_options.threads threads. Modules with solve[m] false are skipped
+// and left empty; an empty solve means every module.
+std::vector<std::vector<std::map<int, int>>> enumerate_modules(BooleanNetwork& network,
+                                                              const PercolationResult& percolation,
+                                                              const std::vector<std::vector<int>>& modules,
+                                                              const std::vector<bool>& solve = {});
+
+// Trap spaces of every module, solved in parallel and combined lazily.
+ComponentProduct find_stable_states_product(BooleanNetwork& network,
+                                            const PercolationResult& percolation,
+                                            const std::vector<std::vector<int>>& modules);
+
+// Percolation under the given external fixings, or just the fixings when
+// enumeration_options.percolate is off.
+PercolationResult get_percolation(BooleanNetwork& network, const std::map<int, int>& fixed_externals);
+
+// Every trap space left by the percolation (module product or single enumeration),
+// largest first; never empty. With a sink they are handed to it instead and the
+// returned vector is empty. Module products reach the sink only once every module is solved.
+std::vector<std::map<int, int>> find_trap_spaces(BooleanNetwork& network, const PercolationResult& percolation,
+                                                 const TrapSpaceSink& sink = {});
+
+SolutionObjects find_stable_states(BooleanNetwork& network);
+
+SolutionObjects find_stable_states_and_external(BooleanNetwork& network,
+                                                bool is_verify_sub_solutions = false,
+                                                bool is_save = false);
+
+#endif // ILP_MODEL_BUILDER_H
@@ -0,0 +1,73 @@
+#ifndef INCLUDING_SOLUTIONS_H
+#define INCLUDING_SOLUTIONS_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BooleanNetwork.h"
+#include "SolutionObjects.h"
+
+// solutions.all_included_solutions[id] lists the trap spaces with more fixed nodes that
+// lie inside solution id under a compatible external assignment.
+void build_solutions_hierarchy_tree(BooleanNetwork& network, SolutionObjects& solutions);
+
+// Adds the edges from solution_id to the solutions already present that lie inside it.
+// Called as solutions arrive largest first, this builds the same tree incrementally.
+void add_to_solutions_hierarchy_tree(BooleanNetwork& network, SolutionObjects& solutions, int solution_id);
+
+// Results of finished checks by reduced system, shared by all checks of one run.
+class InclusionCache {
+public:
+    bool find(std::string_view key, int& result) const;
+    void insert(std::string key, int result);
+
+private:
+    mutable std::mutex lock;
+    std::map<std::string, int, std::less<>> results;
+};
+
+// Everything the inclusion check of one solution reads, copied out of SolutionObjects
+// so it can run while other solutions are still being added.
+struct InclusionTask {
+    TrapSpace solution;
+    std::vector<std::vector<int>> external_list;
+    std::vector<TrapSpace> included_solutions;                      // only when verifying
+    std::vector<std::vector<std::vector<int>>> included_externals;
+    std::vector<int> not_empty_externals;                           // externals the free nodes read
+};
+
+struct InclusionVerdict {
+    bool included = false;
+    VerificationStatus verification = VerificationStatus::Verified;
+    // External assignments under which no included space lies inside the solution; they
+    // split off as a new solution.
+    std::vector<std::vector<int>> not_included_externals;
+
+    void mark_verification(VerificationStatus status)
+    {
+        if (status > verification) verification = status;
+    }
+};
+
+// Needs solutions.all_included_solutions[solution_id].
+InclusionTask make_inclusion_task(BooleanNetwork& network, SolutionObjects& solutions, int solution_id,
+                                  bool is_verify_sub_solutions);
+
+// Thread-safe; checks_left splits the rest of the inclusion budget.
+InclusionVerdict check_inclusion_task(BooleanNetwork& network, const InclusionTask& task, InclusionCache& done,
+                                      bool is_verify_sub_solutions, int checks_left);
+
+void apply_inclusion_verdict(SolutionObjects& solutions, const InclusionTask& task, const InclusionVerdict& verdict);
+
+// Removes the solutions marked as included and reports the counts.
+void drop_included_solutions(SolutionObjects& solutions, int original_solution_size);
+
+// Drops every solution that contains one of those spaces. With is_verify_sub_solutions
+// the drop is confirmed by a reachability check that every state of the solution
+// reaches one of the included spaces.
+void remove_included_solutions(BooleanNetwork& network, SolutionObjects& solutions, bool is_verify_sub_solutions);
+
+#endif // INCLUDING_SOLUTIONS_H
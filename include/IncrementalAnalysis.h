@@ -0,0 +1,34 @@
+#ifndef INCREMENTAL_ANALYSIS_H
+#define INCREMENTAL_ANALYSIS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BooleanNetwork.h"
+
+struct IncrementalAnalysisResult {
+    std::vector<std::map<int, int>> trap_spaces;    // as find_trap_spaces, largest first
+    int state_nodes = 0;
+    int synthesized_nodes = 0;     // state nodes whose threshold rows were not reused
+    int modules = 0;
+    int enumerated_modules = 0;    // modules whose trap spaces were not reused
+};
+
+// Loads rules_path into the empty network and finds its trap spaces under
+// enumeration_options.fixed_externals, reusing the run recorded in snapshot_path
+// (missing on the first run) and then recording this one there.
+//
+// The snapshot keeps every state node's rule with its threshold rows over input names,
+// and the trap spaces of every module with what they depend on: its members' rules and
+// the values of the known inputs they read. Parsing, the network reductions and
+// percolation are redone in full (they are linear); threshold synthesis only runs for
+// nodes whose rule changed, and only modules whose members or inputs changed are
+// enumerated again (all of them when the enumeration options or the threshold order
+// differ from the snapshot's). A network that does not decompose is a single module, so any edit
+// re-enumerates it.
+IncrementalAnalysisResult analyze_incrementally(BooleanNetwork& network, const std::string& rules_path,
+                                                const std::string& snapshot_path,
+                                                int max_threshold_order = 4);
+
+#endif // INCREMENTAL_ANALYSIS_H
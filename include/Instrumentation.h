@@ -0,0 +1,63 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <string>
+
+// Phase timers and counters for profiling runs. Built with AILP_INSTRUMENTATION the
+// macros below record into a process-wide trace; without it they expand to nothing
+// and the export functions are no-ops, so release builds carry no cost.
+//
+//   AILP_TRACE_SCOPE(scope, "build_ilp_model");      // timed until end of block
+//   AILP_TRACE_ARG(scope, "size", i);                // shown with the event
+//   AILP_TRACE_COUNT("ilp.solves", 1);               // process-wide total
+//
+// Every scope also records the peak resident set size of the process when it closes.
+
+#ifdef AILP_INSTRUMENTATION
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name);
+    ~TraceScope();
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    void arg(const char* key, long long value);
+    void arg(const char* key, const std::string& value);
+
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+    std::vector<std::pair<std::string, std::string>> args;   // value already JSON-encoded
+};
+
+void trace_count(const char* name, long long delta);
+
+#define AILP_TRACE_SCOPE(var, name) TraceScope var(name)
+#define AILP_TRACE_ARG(var, key, value) var.arg(key, value)
+#define AILP_TRACE_COUNT(name, delta) trace_count(name, delta)
+
+// Per-phase totals (calls, total and max microseconds, peak RSS) and counters as JSON.
+bool write_trace_summary(const std::string& path);
+// Every scope as a complete event and every counter total, in Chrome trace-event
+// format (chrome://tracing, Perfetto).
+bool write_chrome_trace(const std::string& path);
+void reset_trace();
+
+#else
+
+#define AILP_TRACE_SCOPE(var, name) ((void)0)
+#define AILP_TRACE_ARG(var, key, value) ((void)0)
+#define AILP_TRACE_COUNT(name, delta) ((void)0)
+
+inline bool write_trace_summary(const std::string&) { return false; }
+inline bool write_chrome_trace(const std::string&) { return false; }
+inline void reset_trace() {}
+
+#endif // AILP_INSTRUMENTATION
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,43 @@
+#ifndef MODULAR_DECOMPOSITION_H
+#define MODULAR_DECOMPOSITION_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "BooleanNetwork.h"
+#include "Percolation.h"
+
+// Weakly connected components of the dependency graph over the free state nodes.
+// Components that read a common external that is still free are merged, so that the
+// product of their trap spaces never pairs two different choices of that external.
+// Each module is sorted and the modules are ordered by their smallest node.
+std::vector<std::vector<int>> get_network_modules(const BooleanNetwork& network,
+                                                  const PercolationResult& percolation);
+
+// Trap spaces of the whole network as the product of the trap spaces of independent
+// modules. Nothing is combined until a caller walks the product.
+class ComponentProduct {
+public:
+    explicit ComponentProduct(std::map<int, int> base = {});
+
+    // Trap spaces of one module, each restricted to that module's nodes. The empty
+    // map (module left free) is a valid member.
+    void add_component(const std::vector<std::map<int, int>>& trap_spaces);
+
+    int num_components() const { return static_cast<int>(components.size()); }
+    int max_fixed() const;
+    // Number of combined trap spaces, saturating at UINT64_MAX.
+    uint64_t size() const;
+
+    // Visits every combination that fixes exactly `fixed` nodes besides the base.
+    void for_each_of_size(int fixed, const std::function<void(const std::map<int, int>&)>& visit) const;
+
+private:
+    std::map<int, int> base;
+    // Per module: number of fixed nodes -> trap spaces of that size.
+    std::vector<std::map<int, std::vector<std::map<int, int>>>> components;
+};
+
+#endif // MODULAR_DECOMPOSITION_H
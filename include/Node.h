@@ -13,7 +13,7 @@ public:
     int id;                                      // Unique node ID
     std::string name;                            // Node name
     std::string expr;                            // Boolean expression
-    std::pair<std::vector<int>, int> threshold; // (weights, threshold)
+    std::vector<std::pair<std::vector<int>, int>> threshold; // AND of (weights, threshold) rows
     bool external;
     SymEngine::RCP<const SymEngine::Basic> boolean_function;
     SymEngine::RCP<const SymEngine::Basic> original_boolean_function;
@@ -23,13 +23,21 @@ public:
 
     Node(int _id, const std::string& _name, const std::string& _expr);
 
-    std::pair<std::vector<int>, int> getThresholdFunction() const {
+    std::vector<std::pair<std::vector<int>, int>> getThresholdFunction() const {
         return threshold;
     }
 
+    // Fewest threshold rows (searching order 1, 2, ..., max_order) whose AND equals the
+    // node's function; falls back to one clause per false point beyond max_order.
+    // Rows are only ever combined by AND: an OR-type function such as (a & b) | (c & d)
+    // is synthesized as rows of its conjunctive form (two here), never as the complement
+    // of an AND, so ORs of many wide terms hit max_order and get the clause fallback.
+    // Nodes with more than 8 inputs only try a single row, and each order gets 10 s of
+    // solver time (keeping a feasible incumbent, else falling back to clauses).
     void solveThresholdFunction(
         int networkSize,
-        const std::unordered_map<std::string, int>& nameToId
+        const std::unordered_map<std::string, int>& nameToId,
+        int max_order = 4
     );
 
     std::vector<std::string> getParents() const;
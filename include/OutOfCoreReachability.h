@@ -0,0 +1,22 @@
+#ifndef OUT_OF_CORE_REACHABILITY_H
+#define OUT_OF_CORE_REACHABILITY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Reachability.h"
+
+// Largest system the out-of-core search accepts; states are still packed into 64 bits.
+const int MAX_OUT_OF_CORE_VARS = 56;
+
+// External-memory backward BFS. The visited bitset is split into page files under
+// options.scratch_directory that are memory-mapped on demand, with at most
+// memory_budget_bytes of them mapped at once. Each BFS level is streamed through
+// sorted, delta-compressed run files and merged on read. Returns the number of
+// unreachable states, or -1 when the scratch budget is exhausted or I/O fails.
+long long count_unreachable_states_out_of_core(const ExplorationSystem& system,
+                                               const std::vector<std::vector<int>>& initial_cubes,
+                                               const ReachabilityOptions& options);
+
+#endif // OUT_OF_CORE_REACHABILITY_H
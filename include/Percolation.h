@@ -0,0 +1,37 @@
+#ifndef PERCOLATION_H
+#define PERCOLATION_H
+
+#include <map>
+#include <vector>
+
+#include "BooleanNetwork.h"
+
+// Result of propagating constants through the threshold functions. Inputs are keyed
+// by network index (state nodes first, then state_size + external index).
+struct PercolationResult {
+    std::map<int, int> forced_states;   // state node id -> value it is forced to
+    std::map<int, int> known_inputs;    // forced states and user-fixed externals
+    std::vector<int> free_states;       // state nodes left to the ILP, ascending
+};
+
+// Fixes every state node whose threshold rows are decided by the known inputs alone:
+// min(sum) >= t in every row forces 1 and max(sum) < t in some row forces 0, taking the
+// worst case over the inputs that are still free (the node itself included). Seeds are the constant
+// nodes (no inputs) and fixed_externals (external index -> value); static nodes are
+// only removed once their value is forced this way.
+PercolationResult percolate_constants(const BooleanNetwork& network,
+                                      const std::map<int, int>& fixed_externals);
+
+// Percolation of the network with the given state nodes held at a value whatever their
+// functions say (node id -> 0 for a knockout, 1 for overexpression). Starts from base,
+// the percolation of the unperturbed network under the same externals, and only
+// recomputes the nodes downstream of the perturbed ones.
+PercolationResult percolate_perturbation(const BooleanNetwork& network, const PercolationResult& base,
+                                         const std::map<int, int>& fixed_states);
+
+// Threshold rows with the known inputs folded into the thresholds and their weights
+// cleared.
+ThresholdFunctions reduce_threshold_functions(const ThresholdFunctions& functions,
+                                              const std::map<int, int>& known_inputs);
+
+#endif // PERCOLATION_H
@@ -0,0 +1,49 @@
+#ifndef PERTURBATION_SCREEN_H
+#define PERTURBATION_SCREEN_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BooleanNetwork.h"
+
+// State node id -> value it is held at: 0 for a knockout, 1 for overexpression.
+using Perturbation = std::map<int, int>;
+
+// Trap spaces of one perturbed network compared with the wild type. The comparison
+// leaves out the perturbed nodes, whose values are imposed rather than an outcome.
+struct PerturbationOutcome {
+    Perturbation perturbation;
+    std::vector<std::map<int, int>> trap_spaces;
+    std::vector<std::map<int, int>> appeared;   // not among the wild-type spaces
+    std::vector<std::map<int, int>> vanished;   // wild-type spaces no longer present
+    bool reused_model = false;                  // solved on a copy of the wild-type model
+};
+
+struct PerturbationScreenResult {
+    std::vector<std::map<int, int>> wild_type;
+    std::vector<PerturbationOutcome> outcomes;
+};
+
+// Every single perturbation of the state nodes, knockouts and/or overexpressions.
+std::vector<Perturbation> single_perturbations(const BooleanNetwork& network, bool knockouts, bool overexpressions);
+
+// Every pair of single perturbations on two different nodes.
+std::vector<Perturbation> double_perturbations(const BooleanNetwork& network, bool knockouts, bool overexpressions);
+
+// Trap spaces of the wild type and of every perturbation, under
+// enumeration_options.fixed_externals. Threshold functions are never re-synthesized:
+// a perturbed node simply stops reading its function. Percolation is only redone
+// downstream of the perturbed nodes. When all of them are free in the wild type, the
+// perturbation runs on a copy of one wild-type model with those nodes clamped;
+// otherwise the wild type has folded them in as constants and the perturbed network
+// is enumerated from scratch. Perturbations run on up to enumeration_options.threads
+// threads (0 = all hardware threads).
+PerturbationScreenResult screen_perturbations(BooleanNetwork& network, const std::vector<Perturbation>& perturbations);
+
+// Tab-separated report: perturbation (`name=v,...`), number of trap spaces, appeared
+// and vanished spaces (`;`-separated).
+bool write_screen_report(const BooleanNetwork& network, const PerturbationScreenResult& result,
+                         const std::string& path);
+
+#endif // PERTURBATION_SCREEN_H
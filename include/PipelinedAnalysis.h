@@ -0,0 +1,34 @@
+#ifndef PIPELINED_ANALYSIS_H
+#define PIPELINED_ANALYSIS_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+
+#include "BooleanNetwork.h"
+#include "SolutionObjects.h"
+
+struct PipelineOptions {
+    // Run find_stable_states_and_external as a pipeline instead of phase by phase.
+    bool enabled = false;
+    // Items each queue holds before the stage feeding it waits.
+    size_t queue_capacity = 256;
+};
+
+inline PipelineOptions pipeline_options;
+
+// Turns one enumerated trap space into solutions with their external assignments.
+using ExternalAssigner = std::function<SolutionObjects(const std::map<int, int>&)>;
+
+// Enumeration, external assignment with hierarchy insertion, and the inclusion checks
+// run concurrently, joined by two bounded queues. Trap spaces arrive largest first, so when a space comes out of the
+// solver every space that can lie inside it is already in the hierarchy tree; its
+// edges are added right away and its inclusion check is queued for the checking
+// threads (enumeration_options.threads minus the two other stages, at least one).
+// Since assign_externals sees one space at a time, the result matches
+// remove_included_solutions run after the whole enumeration when the assignment of a
+// space does not depend on the others.
+SolutionObjects find_and_prune_pipelined(BooleanNetwork& network, const ExternalAssigner& assign_externals,
+                                         bool is_verify_sub_solutions);
+
+#endif // PIPELINED_ANALYSIS_H
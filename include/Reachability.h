@@ -0,0 +1,123 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <atomic>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "SolutionObjects.h"
+
+class BooleanNetwork;
+
+struct ReachabilityOptions {
+    // Above this many explored nodes the explicit BFS is replaced by the BDD backend.
+    int symbolic_threshold = 23;
+    // The BDD backend gives up (returns -1) once its node table grows past this.
+    size_t symbolic_node_limit = 20000000;
+
+    // Worker threads for the explicit BFS (0 = all hardware threads); systems with
+    // fewer explored nodes than parallel_min_vars stay single-threaded.
+    int threads = 0;
+    int parallel_min_vars = 18;
+
+    // Out-of-core explicit search, used when the visited bitset does not fit in
+    // memory_budget_bytes or the BDD backend gives up. Disabled while scratch_directory
+    // is empty. Visited pages are memory-mapped files of visited_page_bytes each.
+    std::string scratch_directory;
+    size_t memory_budget_bytes = size_t(1) << 30;
+    size_t scratch_budget_bytes = size_t(64) << 30;
+    size_t visited_page_bytes = size_t(64) << 20;
+
+    // Try the SCC decomposition of the explored dependency graph before the monolithic
+    // search when at least decomposition_min_vars nodes are explored. A component is
+    // checked once per assignment of its free upstream inputs, up to
+    // 2^decomposition_max_context_vars assignments.
+    bool decompose = true;
+    int decomposition_min_vars = 12;
+    int decomposition_max_context_vars = 10;
+
+    // Random asynchronous trajectories run before the exhaustive check (0 disables).
+    int sampling_trajectories = 32;
+    int sampling_trajectory_length = 1000;
+    unsigned sampling_seed = 0;
+    // Sampling can only prove non-inclusion (a fixed point outside the included
+    // subspaces). When set, "every trajectory reached an included subspace" is
+    // also accepted as inclusion without running the exhaustive check.
+    bool trust_sampling = false;
+};
+
+inline ReachabilityOptions reachability_options;
+
+// Atomic: checks of a pipelined run sample concurrently.
+struct SamplingStats {
+    std::atomic<int> checks{0};
+    std::atomic<int> traps_found{0};
+    std::atomic<int> all_reached{0};
+    std::atomic<int> inconclusive{0};
+    std::atomic<long long> hits{0};     // trajectories that entered an included subspace
+    std::atomic<long long> misses{0};   // trajectories that ran out of steps
+};
+
+inline SamplingStats sampling_stats;
+
+enum class SamplingOutcome { Inconclusive, TrapFound, AllReached };
+
+// Reduced threshold functions of the non-stable nodes of one solution in compressed
+// sparse row form. Slot k stands for network node node_ids[k] and owns rows
+// [row_begin[k], row_begin[k + 1]); row r owns the entries [entry_begin[r],
+// entry_begin[r + 1]) of columns/weights, where columns are slots. Removed nodes are
+// marked dead in alive and merged-away entries have column -1. Only lives during one
+// reduction, so it allocates from the check's memory resource.
+struct ThresholdCSR {
+    explicit ThresholdCSR(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : node_ids(memory), alive(memory), row_begin(memory), entry_begin(memory),
+          columns(memory), weights(memory), thresholds(memory) {}
+
+    std::pmr::vector<int> node_ids;
+    std::pmr::vector<char> alive;
+    std::pmr::vector<int> row_begin;
+    std::pmr::vector<int> entry_begin;
+    std::pmr::vector<int> columns;
+    std::pmr::vector<int> weights;
+    std::pmr::vector<int> thresholds;
+};
+
+// Threshold update functions of the explored nodes, indexed by their position in
+// node_ids instead of their network id. Rows of one node are contiguous:
+// node v owns rows [row_begin[v], row_begin[v + 1]) and is on iff all of them hold.
+struct ExplorationSystem {
+    int num_vars = 0;
+    std::vector<int> node_ids;      // network id of each explored position
+    std::vector<int> row_begin;     // num_vars + 1 offsets
+    std::vector<int> weights;       // rows x num_vars, row-major
+    std::vector<int> thresholds;    // one per row
+    // How node v depends on itself: 1 positive, -1 negative, 0 binate or unknown, 2 not at
+    // all. Empty means unknown for every node.
+    std::vector<int> self_unateness;
+
+    int num_rows() const { return static_cast<int>(thresholds.size()); }
+    const int* row(int r) const { return weights.data() + static_cast<size_t>(r) * num_vars; }
+};
+
+std::vector<int> get_included_solution_cube(const TrapSpace& included_solution,
+                                            const std::vector<int>& state_to_explore);
+
+// Intermediate structures come from `memory` (a CheckArena's resource, typically); the
+// returned system is allocated normally and outlives it.
+ExplorationSystem get_reduced_threshold_functions(BooleanNetwork& network,
+                                                  const std::map<int, int>& stable_nodes,
+                                                  const std::vector<int>& external,
+                                                  const std::vector<TrapSpace>& included_solutions,
+                                                  std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+SamplingOutcome sample_reachability(const std::vector<TrapSpace>& included_solutions,
+                                    const ExplorationSystem& system);
+
+int check_if_reachable(const TrapSpace& solution,
+                       const std::vector<TrapSpace>& included_solutions,
+                       const ExplorationSystem& system);
+
+#endif // REACHABILITY_H
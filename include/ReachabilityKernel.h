@@ -0,0 +1,82 @@
+#ifndef REACHABILITY_KERNEL_H
+#define REACHABILITY_KERNEL_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Reachability.h"
+
+// Explicit-state backward BFS over bit-packed states (bit v = explored position v).
+// All kernels return the number of states that cannot reach any initial cube, or -1
+// when max_states (0 = unlimited) states were expanded before the search finished or
+// when `cancelled`, polled once per BFS level, returned true.
+
+// Lets callers stop a search (a run out of budget) without the kernels depending on it.
+using SearchCancelled = std::function<bool()>;
+
+// Largest system the explicit kernels accept; the visited bitset has 2^num_vars bits.
+const int MAX_EXPLICIT_VARS = 40;
+
+std::vector<uint64_t> expand_cubes(const std::vector<std::vector<int>>& initial_cubes);
+
+// Keeps the weighted row sums of every frontier state and derives a neighbour's sums
+// from its parent's by adding the weight column of the flipped variable.
+long long count_unreachable_states(const ExplorationSystem& system,
+                                   const std::vector<std::vector<int>>& initial_cubes,
+                                   uint64_t max_states = 0,
+                                   const SearchCancelled& cancelled = {});
+
+// Recomputes every row sum from scratch for every neighbour, as the original BFS did.
+// Kept as a baseline for benchmarks and cross-checks.
+long long count_unreachable_states_full_recompute(const ExplorationSystem& system,
+                                                  const std::vector<std::vector<int>>& initial_cubes,
+                                                  uint64_t max_states = 0);
+
+// Batched transition test for a block of frontier states. The row sums of all states
+// in the block are computed as a matrix product over the weight columns (int16 lanes
+// when every row fits, int32 otherwise), with an AVX2 path on x86 and a scalar
+// fallback elsewhere. For each state it emits the mask of variables whose flip leads
+// to a predecessor.
+class FrontierBlockKernel {
+public:
+    static constexpr size_t BLOCK_SIZE = 64;
+
+    explicit FrontierBlockKernel(const ExplorationSystem& system);
+
+    void evaluate(const uint64_t* states, size_t count, uint64_t* predecessor_masks) const;
+    bool uses_avx2() const { return avx2; }
+    bool uses_int16() const { return narrow; }
+
+private:
+    int num_vars;
+    int rows;
+    int padded_rows;
+    bool narrow;
+    bool avx2;
+    std::vector<int> row_begin;
+    std::vector<int> row_node;
+    std::vector<int16_t> columns16;     // num_vars x padded_rows, column-major
+    std::vector<int32_t> columns32;
+    std::vector<int16_t> diagonal16;    // weight of each row's own node
+    std::vector<int32_t> diagonal32;
+    std::vector<int16_t> thresholds16;
+    std::vector<int32_t> thresholds32;
+};
+
+// Level-synchronous BFS that feeds its frontier through FrontierBlockKernel.
+long long count_unreachable_states_batched(const ExplorationSystem& system,
+                                           const std::vector<std::vector<int>>& initial_cubes,
+                                           uint64_t max_states = 0,
+                                           const SearchCancelled& cancelled = {});
+
+// Multi-threaded variant: each level's frontier is split into blocks that workers claim
+// dynamically, the visited bitset is updated with atomic OR and every worker appends to
+// its own next-frontier buffer. Stops as soon as all 2^n states are reached.
+long long count_unreachable_states_parallel(const ExplorationSystem& system,
+                                            const std::vector<std::vector<int>>& initial_cubes,
+                                            int threads,
+                                            uint64_t max_states = 0,
+                                            const SearchCancelled& cancelled = {});
+
+#endif // REACHABILITY_KERNEL_H
@@ -0,0 +1,35 @@
+#ifndef SCENARIO_SWEEP_H
+#define SCENARIO_SWEEP_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BooleanNetwork.h"
+
+// Trap spaces of every scenario, merged: trap_spaces holds each distinct space once
+// (largest first) and scenarios_of[i] the indices of the scenarios it occurs in.
+struct ScenarioSweepResult {
+    std::vector<std::map<int, int>> scenarios;      // external index -> value
+    std::vector<std::map<int, int>> trap_spaces;
+    std::vector<std::vector<int>> scenarios_of;
+};
+
+// One scenario per line, `name=0,name=1,...` over external nodes, or `-` for none.
+// Blank lines and lines starting with '#' are skipped; throws std::invalid_argument on
+// unknown or non-external names.
+std::vector<std::map<int, int>> read_scenarios(BooleanNetwork& network, const std::string& path);
+
+// Enumerates the trap spaces of every scenario from a single model: it is built once
+// over the free nodes left by percolating the constants, with the symmetry-breaking
+// rows and FVS branch priorities every scenario shares, and each scenario runs on a
+// copy with its externals fixed through variable bounds and the size moved through
+// the right-hand side of fixed_count. Scenarios run in parallel on up to
+// enumeration_options.threads threads (0 = all hardware threads), one Gurobi
+// environment per thread.
+ScenarioSweepResult sweep_scenarios(BooleanNetwork& network, const std::vector<std::map<int, int>>& scenarios);
+
+// Tab-separated table: trap space (`name=v,...`), number of fixed nodes, scenarios.
+bool write_sweep_table(const BooleanNetwork& network, const ScenarioSweepResult& result, const std::string& path);
+
+#endif // SCENARIO_SWEEP_H
@@ -6,11 +6,19 @@
 #include <string>
 #include <stdexcept>
 
+// What is known about a kept trap space not containing a smaller one it could lead
+// into: Verified when no inclusion check on it was left open, Unverified when a check
+// was abandoned (its -1), SkippedForBudget when the run's budget ran out first.
+enum class VerificationStatus { Verified, Unverified, SkippedForBudget };
+
+const char* verification_status_name(VerificationStatus status);
+
 class TrapSpace {
 public:
     int solution_id;
     std::map<int, int> stable_nodes;
     bool included_solution = false;
+    VerificationStatus verification = VerificationStatus::Verified;
 
     TrapSpace(int id, const std::map<int, int>& nodes)
         : solution_id(id), stable_nodes(nodes) {}
@@ -19,6 +27,12 @@ public:
     {
         included_solution = true;
     }
+
+    // Keeps the weakest status seen over all of its checks
+    void mark_verification(VerificationStatus status)
+    {
+        if (status > verification) verification = status;
+    }
 };
 
 class SolutionObjects {
@@ -30,6 +44,8 @@ public:
     std::map<std::pair<int, int>, std::vector<std::vector<int>>> all_included_externals;
     int solution_id_counter;
     int external_id_counter;
+    // False when the budget cut the enumeration short: solutions holds what was found.
+    bool complete = true;
 
     SolutionObjects();
 
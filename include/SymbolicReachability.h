@@ -0,0 +1,88 @@
+#ifndef SYMBOLIC_REACHABILITY_H
+#define SYMBOLIC_REACHABILITY_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "Reachability.h"
+
+class BddNodeLimitExceeded : public std::runtime_error {
+public:
+    BddNodeLimitExceeded() : std::runtime_error("BDD node limit exceeded") {}
+};
+
+// Minimal reduced ordered BDD package used by the symbolic reachability backend.
+// Variable i is explored position i; there is no garbage collection, a manager
+// lives for a single check and is dropped afterwards.
+class BddManager {
+public:
+    using Ref = int;
+
+    BddManager(int num_vars, size_t node_limit);
+
+    Ref zero() const { return 0; }
+    Ref one() const { return 1; }
+    Ref var(int v);
+
+    Ref ite(Ref f, Ref g, Ref h);
+    Ref apply_and(Ref f, Ref g) { return ite(f, g, zero()); }
+    Ref apply_or(Ref f, Ref g) { return ite(f, one(), g); }
+    Ref apply_xor(Ref f, Ref g) { return ite(f, negate(g), g); }
+    Ref negate(Ref f) { return ite(f, zero(), one()); }
+
+    Ref cofactor(Ref f, int v, bool value);
+    // f with x_v replaced by !x_v
+    Ref swap_var(Ref f, int v);
+
+    Ref threshold(const int* weights, int threshold);
+    Ref cube(const std::vector<int>& values);
+
+    double sat_count(Ref f);
+    size_t size() const { return nodes.size(); }
+
+private:
+    struct BddNode {
+        int var;
+        Ref low;
+        Ref high;
+    };
+
+    // Direct-mapped computed table, as in most BDD packages; collisions just overwrite.
+    struct IteEntry {
+        Ref f = -1;
+        Ref g = -1;
+        Ref h = -1;
+        Ref result = -1;
+    };
+
+    int num_vars;
+    size_t node_limit;
+    std::vector<BddNode> nodes;
+    std::unordered_map<uint64_t, Ref> unique_table;
+    std::vector<IteEntry> ite_cache;
+    std::unordered_map<uint64_t, Ref> cofactor_cache;
+
+    Ref make_node(int v, Ref low, Ref high);
+    int top_var(Ref f) const { return nodes[f].var; }
+    Ref restrict_top(Ref f, int v, bool value) const;
+};
+
+// enabled_flips[v] is x_v XOR f_v, the states in which flipping node v is an
+// asynchronous transition.
+std::vector<BddManager::Ref> symbolic_enabled_flips(BddManager& bdd, const ExplorationSystem& system);
+
+// Asynchronous preimage / image of a set of states.
+BddManager::Ref symbolic_preimage(BddManager& bdd, const std::vector<BddManager::Ref>& enabled_flips,
+                                  BddManager::Ref states);
+BddManager::Ref symbolic_image(BddManager& bdd, const std::vector<BddManager::Ref>& enabled_flips,
+                               BddManager::Ref states);
+
+// Number of states that cannot reach any of the initial cubes (-1 when the BDD
+// node limit is hit). Cubes hold 0/1 per explored position, -1 for free.
+double symbolic_count_unreachable_states(const ExplorationSystem& system,
+                                         const std::vector<std::vector<int>>& initial_cubes,
+                                         size_t node_limit);
+
+#endif // SYMBOLIC_REACHABILITY_H
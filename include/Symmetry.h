@@ -0,0 +1,29 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <map>
+#include <vector>
+
+#include "BooleanNetwork.h"
+#include "Percolation.h"
+
+// Permutation of network node ids (perm[i] == i for every node it does not move).
+using NodePermutation = std::vector<int>;
+
+// Generators of a group of permutations of the free nodes that map every reduced
+// threshold function onto the function of the image node: equal thresholds row by row,
+// equal static flags and w[pi(k)][pi(p)] == w[k][p] in every row, with externals and known
+// inputs left in place. Candidate images come from colour refinement of the weighted
+// interaction graph; each generator is found by a backtracking search that gives up
+// after max_search_steps candidate tries.
+std::vector<NodePermutation> find_symmetries(const BooleanNetwork& network,
+                                             const PercolationResult& percolation,
+                                             int max_search_steps = 100000);
+
+// Closes the trap spaces under the generators (node i of a space moves to perm[i]) and
+// drops duplicates. The result stays largest first; within one size the input spaces
+// come before the images.
+std::vector<std::map<int, int>> expand_orbits(const std::vector<std::map<int, int>>& trap_spaces,
+                                              const std::vector<NodePermutation>& generators);
+
+#endif // SYMMETRY_H
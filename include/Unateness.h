@@ -0,0 +1,21 @@
+#ifndef UNATENESS_H
+#define UNATENESS_H
+
+#include <cstdint>
+#include <vector>
+
+enum class Unateness { Independent, Positive, Negative, Binate };
+
+// Functions with more inputs than this are classified from their weight signs.
+const int MAX_TRUTH_TABLE_INPUTS = 20;
+
+// Truth table of [sum_i weights[i] * x_i >= threshold], bit m of the table holding the
+// value for the assignment whose bit i is x_i. Tables shorter than a word are padded
+// by repeating them.
+std::vector<uint64_t> threshold_truth_table(const std::vector<int>& weights, int threshold);
+
+// Unateness of every input of a truth table, comparing the two cofactors of each input
+// a word at a time.
+std::vector<Unateness> get_unateness(const std::vector<uint64_t>& table, int num_inputs);
+
+#endif // UNATENESS_H
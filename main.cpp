@@ -32,9 +32,57 @@
 
     return 0;
 }*/
-#include "expressionParser.h"
+#include "expressionparser.h"
+#include "AnalysisDaemon.h"
+#include "ScenarioSweep.h"
+#include "PerturbationScreen.h"
+#include "IncrementalAnalysis.h"
+
+int main(int argc, char** argv) {
+    // ailp serve <rules file> <socket path>: keep the network loaded and answer queries
+    if (argc == 4 && std::string(argv[1]) == "serve") {
+        AnalysisSession session(argv[2]);
+        return run_daemon(session, argv[3]);
+    }
+
+    // ailp sweep <rules file> <scenario file> <output.tsv>: trap spaces of every scenario
+    if (argc == 5 && std::string(argv[1]) == "sweep") {
+        BooleanNetwork network(argv[2]);
+        ScenarioSweepResult result = sweep_scenarios(network, read_scenarios(network, argv[3]));
+        if (!write_sweep_table(network, result, argv[4])) {
+            std::cerr << "Cannot write " << argv[4] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // ailp screen <rules file> single|double <output.tsv>: knockouts and overexpressions
+    if (argc == 5 && std::string(argv[1]) == "screen") {
+        std::string mode = argv[3];
+        if (mode != "single" && mode != "double") {
+            std::cerr << "Screen mode must be single or double" << std::endl;
+            return 1;
+        }
+        BooleanNetwork network(argv[2]);
+        auto perturbations = mode == "single" ? single_perturbations(network, true, true)
+                                              : double_perturbations(network, true, true);
+        PerturbationScreenResult result = screen_perturbations(network, perturbations);
+        if (!write_screen_report(network, result, argv[4])) {
+            std::cerr << "Cannot write " << argv[4] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // ailp incremental <rules file> <snapshot>: rerun after editing the rules, reusing
+    // what the edit did not touch; the snapshot is created on the first run
+    if (argc == 4 && std::string(argv[1]) == "incremental") {
+        BooleanNetwork network;
+        IncrementalAnalysisResult result = analyze_incrementally(network, argv[2], argv[3]);
+        std::cout << "Trap spaces: " << result.trap_spaces.size() << std::endl;
+        return 0;
+    }
 
-int main() {
     // std::vector<Node> nodes;
     // std::unordered_map<std::string, int> nameToId;
     //
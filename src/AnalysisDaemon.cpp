@@ -0,0 +1,243 @@
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "AnalysisDaemon.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+// `name=v,name=v` or `-` to node id -> value.
+map<int, int> parse_assignment(BooleanNetwork& network, const string& text) {
+    map<int, int> assignment;
+    if (text == "-") return assignment;
+    stringstream items(text);
+    string item;
+    while (getline(items, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) throw invalid_argument("expected name=value, got " + item);
+        string name = item.substr(0, eq);
+        string value = item.substr(eq + 1);
+        auto it = network.nodes.find(name);
+        if (it == network.nodes.end()) throw invalid_argument("unknown node " + name);
+        if (value != "0" && value != "1") throw invalid_argument("value of " + name + " must be 0 or 1");
+        assignment[it->second->id] = value == "1";
+    }
+    return assignment;
+}
+
+map<int, int> parse_space(BooleanNetwork& network, const string& text) {
+    map<int, int> space = parse_assignment(network, text);
+    for (const auto& [id, v] : space) {
+        if (id >= network.state_size) throw invalid_argument(network.index_to_name[id] + " is not a state node");
+    }
+    return space;
+}
+
+// External index -> value
+map<int, int> parse_externals(BooleanNetwork& network, const string& text) {
+    map<int, int> externals;
+    for (const auto& [id, v] : parse_assignment(network, text)) {
+        int ext = id - network.state_size;
+        if (ext < 0 || ext >= network.external_size) {
+            throw invalid_argument(network.index_to_name[id] + " is not an external node");
+        }
+        externals[ext] = v;
+    }
+    return externals;
+}
+
+vector<int> external_vector(BooleanNetwork& network, const string& text) {
+    vector<int> values(network.external_size, 0);
+    for (const auto& [ext, v] : parse_externals(network, text)) values[ext] = v;
+    return values;
+}
+
+string format_space(BooleanNetwork& network, const map<int, int>& space) {
+    if (space.empty()) return "-";
+    string out;
+    for (const auto& [id, v] : space) {
+        if (!out.empty()) out += ",";
+        out += network.index_to_name[id] + "=" + to_string(v);
+    }
+    return out;
+}
+
+bool send_all(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+}
+
+string handle_request(AnalysisSession& session, const string& line) {
+    BooleanNetwork& network = session.get_network();
+    stringstream in(line);
+    string command;
+    in >> command;
+    vector<string> args;
+    for (string arg; in >> arg;) args.push_back(arg);
+
+    try {
+        if (command == "PING" || command == "SHUTDOWN") {
+            return "OK";
+        }
+        if (command == "TRAP_SPACES") {
+            if (args.empty() || args.size() > 2 || (args.size() == 2 && args[1] != "minimal")) {
+                return "ERR usage: TRAP_SPACES <externals> [minimal]";
+            }
+            const auto& spaces = session.trap_spaces(parse_externals(network, args[0]), args.size() == 2);
+            string out = "OK " + to_string(spaces.size());
+            for (size_t i = 0; i < spaces.size(); ++i) {
+                out += (i ? ";" : " ") + format_space(network, spaces[i]);
+            }
+            return out;
+        }
+        if (command == "REACH") {
+            if (args.size() != 3) return "ERR usage: REACH <from> <to>|<to>... <externals>";
+            vector<map<int, int>> to;
+            stringstream targets(args[1]);
+            for (string target; getline(targets, target, '|');) to.push_back(parse_space(network, target));
+            int unreachable = session.count_unreachable(parse_space(network, args[0]), to,
+                                                        external_vector(network, args[2]));
+            return "OK " + to_string(unreachable);
+        }
+        if (command == "INCLUDED") {
+            if (args.size() != 3) return "ERR usage: INCLUDED <from> <inner> <externals>";
+            bool included = session.is_included(parse_space(network, args[0]), parse_space(network, args[1]),
+                                                external_vector(network, args[2]));
+            return included ? "OK 1" : "OK 0";
+        }
+        return "ERR unknown command " + command;
+    } catch (const exception& e) {
+        return string("ERR ") + e.what();
+    }
+}
+
+vector<string> handle_batch(AnalysisSession& session, const vector<string>& lines) {
+    AILP_TRACE_SCOPE(scope, "daemon.batch");
+    AILP_TRACE_ARG(scope, "requests", static_cast<long long>(lines.size()));
+    map<string, string> answered;
+    vector<string> responses;
+    for (const auto& line : lines) {
+        auto it = answered.find(line);
+        if (it == answered.end()) it = answered.emplace(line, handle_request(session, line)).first;
+        responses.push_back(it->second);
+    }
+    return responses;
+}
+
+int run_daemon(AnalysisSession& session, const string& socket_path) {
+    sockaddr_un address{};
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path too long: " << socket_path << endl;
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    // A client hanging up mid-response must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        perror("socket");
+        return 1;
+    }
+    // Only a socket left behind by an earlier run is replaced, never another file
+    struct stat existing;
+    if (lstat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            cerr << "Not a socket, refusing to replace: " << socket_path << endl;
+            close(server);
+            return 1;
+        }
+        unlink(socket_path.c_str());
+    }
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(server, 16) < 0) {
+        perror("bind");
+        close(server);
+        return 1;
+    }
+    cout << "Serving " << session.get_network().state_size << " state nodes on " << socket_path << endl;
+
+    bool shutdown_requested = false;
+    while (!shutdown_requested) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            // Out of descriptors or memory: wait for some to be released
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                continue;
+            }
+            perror("accept");
+            close(server);
+            unlink(socket_path.c_str());
+            return 1;
+        }
+
+        string buffer;
+        vector<string> batch;
+        char chunk[4096];
+        bool connected = true;
+        while (connected && !shutdown_requested) {
+            ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+            connected = n > 0;
+            if (connected) buffer.append(chunk, n);
+
+            // Complete lines; a blank line (or the end of the connection) closes a batch
+            size_t newline;
+            vector<vector<string>> ready;
+            while ((newline = buffer.find('\n')) != string::npos) {
+                string line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty()) {
+                    if (!batch.empty()) ready.push_back(move(batch));
+                    batch.clear();
+                } else {
+                    batch.push_back(line);
+                }
+            }
+            if (!connected) {
+                if (!buffer.empty()) batch.push_back(buffer);
+                if (!batch.empty()) ready.push_back(move(batch));
+            }
+
+            for (const auto& requests : ready) {
+                string reply;
+                for (const auto& response : handle_batch(session, requests)) reply += response + "\n";
+                reply += "\n";
+                if (!send_all(client, reply)) connected = false;
+                for (const auto& request : requests) {
+                    string command;
+                    stringstream(request) >> command;
+                    if (command == "SHUTDOWN") shutdown_requested = true;
+                }
+            }
+        }
+        close(client);
+    }
+
+    close(server);
+    unlink(socket_path.c_str());
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "AnalysisSession.h"
+#include "CheckArena.h"
+#include "Instrumentation.h"
+#include "Reachability.h"
+#include "SolutionObjects.h"
+
+using namespace std;
+
+AnalysisSession::AnalysisSession(const string& rules_path) : network(rules_path) {}
+
+const PercolationResult& AnalysisSession::percolation(const map<int, int>& fixed_externals) {
+    auto it = percolation_cache.find(fixed_externals);
+    if (it == percolation_cache.end()) {
+        it = percolation_cache.emplace(fixed_externals, get_percolation(network, fixed_externals)).first;
+    }
+    return it->second;
+}
+
+const vector<map<int, int>>& AnalysisSession::trap_spaces(const map<int, int>& fixed_externals,
+                                                          bool minimal_only) {
+    for (const auto& [ext, v] : fixed_externals) {
+        if (ext < 0 || ext >= network.external_size || (v != 0 && v != 1)) {
+            throw invalid_argument("external " + to_string(ext) + " cannot be fixed to " + to_string(v));
+        }
+    }
+
+    auto key = make_pair(fixed_externals, minimal_only);
+    auto it = trap_space_cache.find(key);
+    if (it != trap_space_cache.end()) {
+        AILP_TRACE_COUNT("session.trap_space_hits", 1);
+        return it->second;
+    }
+
+    AILP_TRACE_SCOPE(scope, "session.trap_spaces");
+    bool saved_minimal_only = enumeration_options.minimal_only;
+    enumeration_options.minimal_only = minimal_only;
+    vector<map<int, int>> spaces;
+    try {
+        spaces = find_trap_spaces(network, percolation(fixed_externals));
+    } catch (...) {
+        enumeration_options.minimal_only = saved_minimal_only;
+        throw;
+    }
+    enumeration_options.minimal_only = saved_minimal_only;
+    return trap_space_cache.emplace(key, move(spaces)).first->second;
+}
+
+int AnalysisSession::count_unreachable(const map<int, int>& from,
+                                       const vector<map<int, int>>& to,
+                                       const vector<int>& externals) {
+    if (static_cast<int>(externals.size()) != network.external_size) {
+        throw invalid_argument("expected " + to_string(network.external_size) + " external values, got "
+                               + to_string(externals.size()));
+    }
+    auto key = make_tuple(from, to, externals);
+    auto it = reachability_cache.find(key);
+    if (it != reachability_cache.end()) {
+        AILP_TRACE_COUNT("session.reachability_hits", 1);
+        return it->second;
+    }
+
+    TrapSpace solution(0, from);
+    vector<TrapSpace> included;
+    for (size_t i = 0; i < to.size(); ++i) included.emplace_back(i + 1, to[i]);
+    CheckArena arena;
+    auto system = get_reduced_threshold_functions(network, from, externals, included, arena.resource());
+    int unreachable = check_if_reachable(solution, included, system);
+
+    // An abandoned check may succeed with other options later; do not remember it
+    if (unreachable >= 0) reachability_cache.emplace(key, unreachable);
+    return unreachable;
+}
+
+bool AnalysisSession::is_included(const map<int, int>& from,
+                                  const map<int, int>& inner,
+                                  const vector<int>& externals) {
+    for (const auto& [k, v] : from) {
+        auto it = inner.find(k);
+        if (it == inner.end() || it->second != v) return false;
+    }
+    if (inner.size() == from.size()) return true;
+    return count_unreachable(from, {inner}, externals) == 0;
+}
+
+void AnalysisSession::clear_cache() {
+    percolation_cache.clear();
+    trap_space_cache.clear();
+    reachability_cache.clear();
+}
@@ -1,11 +1,22 @@
 #include "BooleanNetwork.h"
 #include "expressionparser.h"
 #include "Node.h"
+#include "Unateness.h"
+#include "Instrumentation.h"
 #include <symengine/basic.h>
 
 BooleanNetwork::BooleanNetwork(const std::string& network_name, const std::string& path)
 {
-    parseExpressions(network_name, nodes, nameToId);
+    parse(network_name);
+    updated_network();
+    synthesize_threshold_functions();
+    get_threshold_functions();
+    compute_unateness();
+}
+
+bool BooleanNetwork::parse(const std::string& network_name)
+{
+    if (!parseExpressions(network_name, nodes, nameToId)) return false;
     for (auto node : nodes)
     {
         if (node.second->external)
@@ -18,14 +29,13 @@ BooleanNetwork::BooleanNetwork(const std::string& network_name, const std::strin
         }
         state_size++;
     }
-    updated_network();
-    get_threshold_functions();
+    return true;
 }
 
 
-std::unordered_map<int, ThresholdFunction> BooleanNetwork::get_threshold_functions()
+std::unordered_map<int, ThresholdFunctions> BooleanNetwork::get_threshold_functions()
 {
-    for(const std::string& node_name : combined_nodes_names)
+    for(const std::string& node_name : state_nodes_names)
     {
         auto node = nodes[node_name];
         threshold_functions[node->id] = node->threshold;
@@ -33,9 +43,102 @@ std::unordered_map<int, ThresholdFunction> BooleanNetwork::get_threshold_functio
     return threshold_functions;
 }
 
+void BooleanNetwork::synthesize_threshold_functions(int max_threshold_order)
+{
+    synthesize_threshold_functions(
+        std::unordered_set<std::string>(state_nodes_names.begin(), state_nodes_names.end()), max_threshold_order);
+}
+
+void BooleanNetwork::synthesize_threshold_functions(const std::unordered_set<std::string>& node_names,
+                                                    int max_threshold_order)
+{
+    // Inputs are indexed by the ids assigned in updated_network
+    std::unordered_map<std::string, int> input_ids;
+    for(const auto& node_name : state_nodes_names) input_ids[node_name] = nodes[node_name]->id;
+    for(const auto& node_name : external_nodes_names) input_ids[node_name] = nodes[node_name]->id;
+
+    for(const auto& node_name : state_nodes_names)
+    {
+        if(!node_names.count(node_name)) continue;
+        AILP_TRACE_SCOPE(scope, "threshold_synthesis");
+        AILP_TRACE_ARG(scope, "node", node_name);
+        nodes[node_name]->solveThresholdFunction(state_size + external_size, input_ids, max_threshold_order);
+        AILP_TRACE_ARG(scope, "rows", static_cast<long long>(nodes[node_name]->threshold.size()));
+        AILP_TRACE_COUNT("synthesis.rows", nodes[node_name]->threshold.size());
+    }
+}
+
+void BooleanNetwork::compute_unateness()
+{
+    unate_dict.clear();
+    for(const auto& [k, functions] : threshold_functions)
+    {
+        std::vector<int> inputs;
+        for(const auto& [weights, threshold] : functions)
+        {
+            for(int i = 0; i < static_cast<int>(weights.size()); ++i)
+            {
+                if(weights[i] != 0) inputs.push_back(i);
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+        inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+        // Rows over the node's inputs; the node's table is the AND of the row tables
+        std::vector<std::pair<std::vector<int>, int>> rows;
+        for(const auto& [weights, threshold] : functions)
+        {
+            std::vector<int> input_weights;
+            for(int i : inputs) input_weights.push_back(i < static_cast<int>(weights.size()) ? weights[i] : 0);
+            rows.emplace_back(input_weights, threshold);
+        }
+
+        std::vector<Unateness> unateness(inputs.size(), Unateness::Independent);
+        if(static_cast<int>(inputs.size()) <= MAX_TRUTH_TABLE_INPUTS)
+        {
+            std::vector<uint64_t> table;
+            for(const auto& [input_weights, threshold] : rows)
+            {
+                auto row_table = threshold_truth_table(input_weights, threshold);
+                if(table.empty()) table = row_table;
+                else for(size_t w = 0; w < table.size(); ++w) table[w] &= row_table[w];
+            }
+            if(!table.empty()) unateness = get_unateness(table, inputs.size());
+        }
+        else
+        {
+            // Sign of every row weight; mixed signs across rows count as binate
+            for(size_t i = 0; i < inputs.size(); ++i)
+            {
+                bool positive = false, negative = false;
+                for(const auto& [input_weights, threshold] : rows)
+                {
+                    positive |= input_weights[i] > 0;
+                    negative |= input_weights[i] < 0;
+                }
+                unateness[i] = positive && negative ? Unateness::Binate
+                             : positive ? Unateness::Positive : Unateness::Negative;
+            }
+        }
+
+        auto& entry = unate_dict[k];
+        entry["positive"];
+        entry["negative"];
+        entry["binate"];
+        for(size_t i = 0; i < inputs.size(); ++i)
+        {
+            if(unateness[i] == Unateness::Positive) entry["positive"].push_back(inputs[i]);
+            else if(unateness[i] == Unateness::Negative) entry["negative"].push_back(inputs[i]);
+            else if(unateness[i] == Unateness::Binate) entry["binate"].push_back(inputs[i]);
+        }
+    }
+}
+
 void BooleanNetwork::updated_network()
 {
-    index_to_name.clear();
+    AILP_TRACE_SCOPE(scope, "updated_network");
+    // Every id assigned below is smaller than the number of parsed nodes
+    index_to_name.assign(nodes.size(), "");
     state_size = 0;
     external_size = 0;
     delete_not_influence_nodes();
@@ -101,6 +204,7 @@ void BooleanNetwork::delete_not_influence_nodes()
     while(true)
     {
         auto new_external_dependent = delete_external_only_depended();
+        AILP_TRACE_COUNT("reduction.external_only_depended", new_external_dependent.size());
         if(new_external_dependent.empty()) break;
     }
     if(size > 300)
@@ -108,6 +212,7 @@ void BooleanNetwork::delete_not_influence_nodes()
         while(true)
         {
             auto new_hole = delete_hole_nodes();
+            AILP_TRACE_COUNT("reduction.hole_nodes", new_hole.size());
             if(new_hole.empty()) break;
         }
     }
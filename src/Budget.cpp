@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+#include "Budget.h"
+
+using namespace std;
+
+namespace {
+
+const double unlimited = numeric_limits<double>::infinity();
+
+atomic<bool> active(false);
+atomic<bool> enumeration_cut(false);
+atomic<bool> inclusion_cut(false);
+chrono::steady_clock::time_point start_time;
+
+// End of the current step of this thread, in seconds since start_budget
+thread_local double step_end = unlimited;
+
+double elapsed() {
+    return chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+}
+
+// Current resident set size; unlike the ru_maxrss peak it goes down again, so one run
+// does not leave later runs in the same process over the limit.
+size_t resident_bytes() {
+#ifdef __APPLE__
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+#else
+    size_t total_pages = 0, resident_pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    int read = fscanf(statm, "%zu %zu", &total_pages, &resident_pages);
+    fclose(statm);
+    if (read != 2) return 0;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Seconds since start_budget at which the phase runs out of time
+double phase_end(BudgetPhase phase) {
+    if (budget_options.time_seconds <= 0) return unlimited;
+    if (phase == BudgetPhase::Enumeration) return budget_options.time_seconds * budget_options.enumeration_share;
+    return budget_options.time_seconds;
+}
+
+}
+
+void start_budget() {
+    start_time = chrono::steady_clock::now();
+    enumeration_cut = false;
+    inclusion_cut = false;
+    active = true;
+}
+
+void stop_budget() {
+    active = false;
+}
+
+double budget_time_left(BudgetPhase phase) {
+    if (!active) return unlimited;
+    return min(phase_end(phase), step_end) - elapsed();
+}
+
+bool budget_exhausted(BudgetPhase phase) {
+    if (!active) return false;
+    if (budget_options.memory_bytes > 0 && resident_bytes() > budget_options.memory_bytes) return true;
+    return budget_time_left(phase) <= 0;
+}
+
+void note_budget_cut(BudgetPhase phase) {
+    (phase == BudgetPhase::Enumeration ? enumeration_cut : inclusion_cut) = true;
+}
+
+bool budget_cut(BudgetPhase phase) {
+    return phase == BudgetPhase::Enumeration ? enumeration_cut : inclusion_cut;
+}
+
+BudgetStep::BudgetStep(BudgetPhase phase, int steps_left) : previous_end(step_end) {
+    double left = budget_time_left(phase);
+    if (active && left != unlimited) step_end = elapsed() + max(0.0, left) / max(1, steps_left);
+}
+
+BudgetStep::~BudgetStep() {
+    step_end = previous_end;
+}
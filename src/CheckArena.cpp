@@ -0,0 +1,28 @@
+#include <vector>
+
+#include "CheckArena.h"
+
+using namespace std;
+
+namespace {
+
+thread_local vector<byte> thread_block;
+thread_local bool thread_block_in_use = false;
+
+}
+
+CheckArena::CheckArena(size_t initial_bytes) : owns_thread_block(!thread_block_in_use) {
+    if (owns_thread_block) {
+        thread_block_in_use = true;
+        if (thread_block.size() < initial_bytes) thread_block.resize(initial_bytes);
+        buffer.emplace(thread_block.data(), thread_block.size(), pmr::new_delete_resource());
+    } else {
+        buffer.emplace(initial_bytes, pmr::new_delete_resource());
+    }
+}
+
+CheckArena::~CheckArena() {
+    // Frees every chunk taken from upstream; the thread block is simply forgotten
+    buffer.reset();
+    if (owns_thread_block) thread_block_in_use = false;
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+#include "DecomposedReachability.h"
+#include "Budget.h"
+#include "ReachabilityKernel.h"
+#include "SymbolicReachability.h"
+
+using namespace std;
+
+vector<vector<int>> get_topological_components(const ExplorationSystem& system) {
+    const int n = system.num_vars;
+    vector<vector<int>> successors(n);
+    for (int v = 0; v < n; ++v) {
+        for (int i = 0; i < n; ++i) {
+            if (i == v) continue;
+            for (int r = system.row_begin[v]; r < system.row_begin[v + 1]; ++r) {
+                if (system.row(r)[i] != 0) {
+                    successors[i].push_back(v);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Tarjan emits a component only after everything downstream of it.
+    vector<int> index(n, -1), low(n, 0);
+    vector<bool> on_stack(n, false);
+    vector<int> stack;
+    vector<vector<int>> components;
+    int counter = 0;
+
+    function<void(int)> connect = [&](int v) {
+        index[v] = low[v] = counter++;
+        stack.push_back(v);
+        on_stack[v] = true;
+        for (int w : successors[v]) {
+            if (index[w] == -1) {
+                connect(w);
+                low[v] = min(low[v], low[w]);
+            } else if (on_stack[w]) {
+                low[v] = min(low[v], index[w]);
+            }
+        }
+        if (low[v] == index[v]) {
+            vector<int> component;
+            int w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                on_stack[w] = false;
+                component.push_back(w);
+            } while (w != v);
+            sort(component.begin(), component.end());
+            components.push_back(component);
+        }
+    };
+
+    for (int v = 0; v < n; ++v) {
+        if (index[v] == -1) connect(v);
+    }
+    reverse(components.begin(), components.end());
+    return components;
+}
+
+namespace {
+
+// Every state of the component reaches the cube's projection, for every assignment of
+// the component's free upstream inputs.
+bool component_reaches(const ExplorationSystem& system, const vector<int>& component,
+                       const vector<int>& cube, const ReachabilityOptions& options) {
+    const int n = system.num_vars;
+    vector<int> position(n, -1);
+    for (size_t i = 0; i < component.size(); ++i) position[component[i]] = i;
+
+    vector<int> free_inputs;
+    for (int i = 0; i < n; ++i) {
+        if (position[i] != -1 || cube[i] != -1) continue;
+        for (int v : component) {
+            bool used = false;
+            for (int r = system.row_begin[v]; r < system.row_begin[v + 1] && !used; ++r) {
+                used = system.row(r)[i] != 0;
+            }
+            if (used) {
+                free_inputs.push_back(i);
+                break;
+            }
+        }
+    }
+    if (static_cast<int>(free_inputs.size()) > options.decomposition_max_context_vars) return false;
+
+    vector<int> target(component.size());
+    for (size_t i = 0; i < component.size(); ++i) target[i] = cube[component[i]];
+
+    for (uint64_t context = 0; context < (uint64_t(1) << free_inputs.size()); ++context) {
+        vector<int> inputs = cube;
+        for (size_t b = 0; b < free_inputs.size(); ++b) inputs[free_inputs[b]] = (context >> b) & 1;
+
+        // Upstream values move into the thresholds of the component's rows.
+        ExplorationSystem sub;
+        sub.num_vars = component.size();
+        sub.row_begin.push_back(0);
+        for (int v : component) {
+            for (int r = system.row_begin[v]; r < system.row_begin[v + 1]; ++r) {
+                const int* w = system.row(r);
+                int threshold = system.thresholds[r];
+                for (int i = 0; i < n; ++i) {
+                    if (position[i] == -1 && inputs[i] == 1) threshold -= w[i];
+                }
+                for (int v2 : component) sub.weights.push_back(w[v2]);
+                sub.thresholds.push_back(threshold);
+            }
+            sub.row_begin.push_back(sub.thresholds.size());
+        }
+
+        double unreachable;
+        if (sub.num_vars <= options.symbolic_threshold && sub.num_vars <= MAX_EXPLICIT_VARS) {
+            unreachable = count_unreachable_states_batched(
+                sub, {target}, 0, [] { return budget_exhausted(BudgetPhase::Inclusion); });
+        } else {
+            unreachable = symbolic_count_unreachable_states(sub, {target}, options.symbolic_node_limit);
+        }
+        if (unreachable != 0) return false;
+    }
+    return true;
+}
+
+}
+
+int decomposed_check_if_reachable(const ExplorationSystem& system,
+                                  const vector<vector<int>>& initial_cubes,
+                                  const ReachabilityOptions& options) {
+    auto components = get_topological_components(system);
+    if (components.size() < 2) return -1;
+
+    for (const auto& cube : initial_cubes) {
+        bool reaches = true;
+        for (const auto& component : components) {
+            bool constrained = any_of(component.begin(), component.end(),
+                                      [&cube](int v) { return cube[v] != -1; });
+            if (!constrained) continue;
+            if (!component_reaches(system, component, cube, options)) {
+                reaches = false;
+                break;
+            }
+        }
+        if (reaches) {
+            cout << "state_to_explore: " << system.num_vars << " decided over "
+                 << components.size() << " components" << endl;
+            return 0;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <set>
+
+#include "FeedbackVertexSet.h"
+#include "Budget.h"
+
+using namespace std;
+
+vector<int> get_feedback_vertex_set(const BooleanNetwork& network, const vector<int>& nodes) {
+    set<int> active(nodes.begin(), nodes.end());
+    map<int, set<int>> predecessors, successors;
+    set<int> self_loops;
+    for (int k : nodes) {
+        auto it = network.threshold_functions.find(k);
+        if (it == network.threshold_functions.end()) continue;
+        for (const auto& [weights, threshold] : it->second) {
+            for (int p : nodes) {
+                if (p >= static_cast<int>(weights.size()) || weights[p] == 0) continue;
+                if (p == k) {
+                    self_loops.insert(k);
+                } else {
+                    predecessors[k].insert(p);
+                    successors[p].insert(k);
+                }
+            }
+        }
+    }
+
+    auto remove_node = [&](int v) {
+        active.erase(v);
+        for (int p : predecessors[v]) successors[p].erase(v);
+        for (int s : successors[v]) predecessors[s].erase(v);
+        predecessors.erase(v);
+        successors.erase(v);
+    };
+
+    vector<int> feedback_vertex_set;
+    while (!active.empty()) {
+        bool reduced = true;
+        while (reduced) {
+            reduced = false;
+            for (auto it = active.begin(); it != active.end();) {
+                int v = *it++;
+                if (self_loops.count(v)) {
+                    feedback_vertex_set.push_back(v);
+                } else if (!predecessors[v].empty() && !successors[v].empty()) {
+                    continue;
+                }
+                remove_node(v);
+                reduced = true;
+            }
+        }
+        if (active.empty()) break;
+
+        int best = *max_element(active.begin(), active.end(), [&](int a, int b) {
+            return predecessors[a].size() * successors[a].size() < predecessors[b].size() * successors[b].size();
+        });
+        feedback_vertex_set.push_back(best);
+        remove_node(best);
+    }
+
+    sort(feedback_vertex_set.begin(), feedback_vertex_set.end());
+    return feedback_vertex_set;
+}
+
+SparseThresholdFunctions to_sparse(const ThresholdFunctions& functions) {
+    SparseThresholdFunctions sparse;
+    for (const auto& [weights, threshold] : functions) {
+        SparseThresholdRow row;
+        row.threshold = threshold;
+        for (size_t p = 0; p < weights.size(); ++p) {
+            if (weights[p] != 0) row.terms.emplace_back(p, weights[p]);
+        }
+        sparse.push_back(move(row));
+    }
+    return sparse;
+}
+
+int evaluate_ternary(const SparseThresholdFunctions& functions, int s, const vector<int>& value) {
+    bool always_on = true;
+    for (const auto& row : functions) {
+        long long y_min = 0, y_max = 0;
+        for (const auto& [p, w] : row.terms) {
+            if (p >= static_cast<int>(value.size())) continue;
+            if (value[p] != -1) {
+                y_min += w * value[p];
+                y_max += w * value[p];
+            } else {
+                if (w < 0 || p == s) y_min += w;
+                if (w > 0 && p != s) y_max += w;
+            }
+        }
+        if (y_max < row.threshold) return 0;
+        always_on &= y_min >= row.threshold;
+    }
+    return always_on ? 1 : -1;
+}
+
+bool enumerate_trap_spaces_fvs(const BooleanNetwork& network,
+                               const PercolationResult& percolation,
+                               const vector<int>& feedback_vertex_set,
+                               int min_size,
+                               bool minimal_only,
+                               uint64_t max_work,
+                               vector<map<int, int>>& trap_spaces) {
+    const int state_size = network.state_size;
+    const int input_size = state_size + network.external_size;
+    const vector<int>& free_states = percolation.free_states;
+
+    // Functions of the free nodes with every known input folded in
+    map<int, SparseThresholdFunctions> functions;
+    uint64_t terms = 0;
+    for (int k : free_states) {
+        functions[k] = to_sparse(reduce_threshold_functions(network.threshold_functions.at(k), percolation.known_inputs));
+        for (const auto& row : functions[k]) terms += row.terms.size() + 1;
+    }
+
+    // Inputs of each free node other than itself and the known inputs
+    map<int, set<int>> inputs;
+    set<int> read_externals;
+    for (int k : free_states) {
+        for (const auto& row : functions[k]) {
+            for (const auto& [p, w] : row.terms) {
+                if (p == k || p >= input_size || percolation.known_inputs.count(p)) continue;
+                inputs[k].insert(p);
+                if (p >= state_size) read_externals.insert(p);
+            }
+        }
+    }
+    vector<int> free_externals(read_externals.begin(), read_externals.end());
+
+    // Worst case: every branch reaches a leaf and propagates every row
+    uint64_t branches = 1;
+    for (size_t i = 0; i < feedback_vertex_set.size(); ++i) {
+        if (branches > max_work / 3) return false;
+        branches *= 3;
+    }
+    for (size_t i = 0; i < free_externals.size(); ++i) {
+        if (branches > max_work / 2) return false;
+        branches *= 2;
+    }
+    if (branches > max_work / max<uint64_t>(terms, 1)) return false;
+
+    // Topological order of the nodes outside the feedback vertex set
+    set<int> in_fvs(feedback_vertex_set.begin(), feedback_vertex_set.end());
+    vector<int> rest;
+    for (int k : free_states) {
+        if (!in_fvs.count(k)) rest.push_back(k);
+    }
+    set<int> in_rest(rest.begin(), rest.end());
+    map<int, vector<int>> successors;
+    map<int, int> in_degree;
+    for (int k : rest) {
+        in_degree[k] = 0;
+        for (int p : inputs[k]) {
+            if (!in_rest.count(p)) continue;
+            successors[p].push_back(k);
+            in_degree[k]++;
+        }
+    }
+    vector<int> order;
+    for (int k : rest) {
+        if (in_degree[k] == 0) order.push_back(k);
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (int s : successors[order[i]]) {
+            if (--in_degree[s] == 0) order.push_back(s);
+        }
+    }
+    if (order.size() != rest.size()) return false;
+
+    // Branching variables: the free externals, then the feedback vertex set. A node
+    // outside the set is decided once the last variable it depends on is assigned, and
+    // a member of the set can be checked once its own inputs are decided, so a branch
+    // is abandoned at the first member it leaves inconsistent.
+    vector<int> variables = free_externals;
+    variables.insert(variables.end(), feedback_vertex_set.begin(), feedback_vertex_set.end());
+    const int depth = variables.size();
+    map<int, int> level;
+    for (int d = 0; d < depth; ++d) level[variables[d]] = d;
+    auto level_of_inputs = [&](int k) {
+        int l = -1;
+        for (int p : inputs[k]) {
+            auto it = level.find(p);
+            if (it != level.end()) l = max(l, it->second);
+        }
+        return l;
+    };
+    vector<vector<int>> evaluate_at(depth + 1), check_at(depth + 1);
+    for (int k : order) {
+        level[k] = level_of_inputs(k);
+        evaluate_at[level[k] + 1].push_back(k);
+    }
+    for (int k : feedback_vertex_set) {
+        check_at[max(level.at(k), level_of_inputs(k)) + 1].push_back(k);
+    }
+
+    vector<int> value(input_size, -1);
+    for (const auto& [i, v] : percolation.known_inputs) {
+        if (i < input_size) value[i] = v;
+    }
+    for (int k : evaluate_at[0]) value[k] = evaluate_ternary(functions[k], k, value);
+
+    // (stable nodes, external values) of every self-consistent assignment
+    vector<pair<map<int, int>, vector<int>>> found;
+    uint64_t visited = 0;
+    bool stopped = false;
+    function<void(int)> branch = [&](int d) {
+        if (d == depth) {
+            map<int, int> stable_states;
+            for (int k : free_states) {
+                if (value[k] != -1) stable_states[k] = value[k];
+            }
+            if (static_cast<int>(stable_states.size()) < max(1, min_size)) return;
+            vector<int> external_values;
+            for (int e : free_externals) external_values.push_back(value[e]);
+            found.emplace_back(move(stable_states), move(external_values));
+            return;
+        }
+        const int v = variables[d];
+        for (int x = v >= state_size ? 0 : -1; x <= 1 && !stopped; ++x) {
+            if ((++visited & 4095) == 0 && budget_exhausted(BudgetPhase::Enumeration)) {
+                note_budget_cut(BudgetPhase::Enumeration);
+                stopped = true;
+                break;
+            }
+            value[v] = x;
+            for (int k : evaluate_at[d + 1]) value[k] = evaluate_ternary(functions[k], k, value);
+            bool consistent = all_of(check_at[d + 1].begin(), check_at[d + 1].end(), [&](int k) {
+                return evaluate_ternary(functions[k], k, value) == value[k];
+            });
+            if (consistent) branch(d + 1);
+        }
+        value[v] = -1;
+    };
+    bool consistent = all_of(check_at[0].begin(), check_at[0].end(), [&](int k) {
+        return evaluate_ternary(functions[k], k, value) == value[k];
+    });
+    if (consistent) branch(0);
+
+    // A space is minimal when no other space under the same externals fixes a superset
+    // of its nodes to the same values.
+    auto contains = [](const map<int, int>& outer, const map<int, int>& inner) {
+        if (outer.size() >= inner.size()) return false;
+        return all_of(outer.begin(), outer.end(), [&inner](const pair<const int, int>& e) {
+            auto it = inner.find(e.first);
+            return it != inner.end() && it->second == e.second;
+        });
+    };
+
+    set<map<int, int>> seen;
+    vector<map<int, int>> result;
+    for (const auto& [stable_states, external_values] : found) {
+        if (minimal_only) {
+            bool contains_other = any_of(found.begin(), found.end(), [&](const auto& other) {
+                return other.second == external_values && contains(stable_states, other.first);
+            });
+            if (contains_other) continue;
+        }
+        if (seen.insert(stable_states).second) result.push_back(stable_states);
+    }
+    stable_sort(result.begin(), result.end(), [](const map<int, int>& a, const map<int, int>& b) {
+        return a.size() > b.size();
+    });
+
+    for (auto& stable_states : result) {
+        stable_states.insert(percolation.forced_states.begin(), percolation.forced_states.end());
+        trap_spaces.push_back(move(stable_states));
+    }
+
+    cout << "FVS: " << feedback_vertex_set.size() << " / " << free_states.size() << " nodes, "
+         << visited << " / " << branches << " branches, " << result.size() << " trap spaces" << endl;
+    return true;
+}
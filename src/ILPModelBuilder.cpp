@@ -1,133 +1,446 @@
+#include <algorithm>
+#include <iostream>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <gurobi_c++.h>
 
 #include "BooleanNetwork.h"
 #include "SolutionObjects.h"
-#include "IncludingSolutions.cpp"
+#include "ILPModelBuilder.h"
+#include "Percolation.h"
+#include "ModularDecomposition.h"
+#include "FeedbackVertexSet.h"
+#include "Symmetry.h"
+#include "Instrumentation.h"
+#include "IncludingSolutions.h"
+#include "Budget.h"
+#include "PipelinedAnalysis.h"
 const int M = 50000;
 
-struct ILPModel {
-    GRBModel model;
-    std::vector<GRBVar> states_vars;
-    std::vector<GRBVar> externals_vars;
-    std::vector<GRBVar> fixed_vars;
+namespace {
+
+// One solve under the enumeration budget: the solver gets the time left as its limit.
+// False when there is no further solution or the budget ran out, which is noted as a cut.
+bool optimize_within_budget(ILPModel& ilp_model) {
+    if (budget_exhausted(BudgetPhase::Enumeration)) {
+        note_budget_cut(BudgetPhase::Enumeration);
+        return false;
+    }
+    double time_left = budget_time_left(BudgetPhase::Enumeration);
+    if (std::isfinite(time_left)) ilp_model.model.set(GRB_DoubleParam_TimeLimit, time_left);
+    ilp_model.model.optimize();
+
+    int status = ilp_model.model.get(GRB_IntAttr_Status);
+    if (status == GRB_TIME_LIMIT) note_budget_cut(BudgetPhase::Enumeration);
+    return status == GRB_OPTIMAL;
+}
+
+// Variables a node block refers to: the shared states/fixed/externals variables by
+// their index in the model (states 2*pos, fixed 2*pos + 1, then the externals) and the
+// block's own auxiliary variables by -(1 + local index).
+struct IndicatorSpec {
+    int indicator;   // fixed variable of the input
+    int var;         // equals the input's states variable when fixed, target otherwise
+    int state;
+    double target;
+};
+
+struct NodeBlock {
+    int aux_count = 0;
+    std::vector<int> always_over;
+    std::vector<int> always_under;
+    int under_var = 0;
+    // Linear rows in CSR form
+    std::vector<int> row_begin{0};
+    std::vector<int> row_vars;
+    std::vector<double> row_coefs;
+    std::vector<char> row_senses;
+    std::vector<double> row_rhs;
+    std::vector<IndicatorSpec> indicators;
+    // Only filled when enumeration_options.model_names is set
+    std::vector<std::string> aux_names;
+    std::vector<std::string> row_names;
 };
 
-ILPModel build_ilp_model(BooleanNetwork& network, int size) {
+// The rows, indicators and AND/OR operands of one free node. Reads the network only,
+// so blocks of different nodes can be built concurrently.
+NodeBlock build_node_block(const BooleanNetwork& network, const PercolationResult& percolation,
+                           const std::vector<int>& position, int pos, bool names) {
+    static const ThresholdFunctions no_rows;
+    NodeBlock block;
+    const int state_size = network.state_size;
+    const int free_size = percolation.free_states.size();
+    const int s_idx = percolation.free_states[pos];
+    const std::string s_name = names ? std::to_string(s_idx) : std::string();
+    auto new_aux = [&block, names](const std::string& name) {
+        if (names) block.aux_names.push_back(name);
+        return -1 - block.aux_count++;
+    };
+
+    // Direction of every input the node is monotone in: +1 positive, -1 negative
+    std::vector<std::pair<int, int>> direction;
+    auto unate = network.unate_dict.find(s_idx);
+    if (unate != network.unate_dict.end()) {
+        for (const auto& [kind, ids] : unate->second) {
+            int d = kind == "positive" ? 1 : kind == "negative" ? -1 : 0;
+            for (int id : ids) direction.emplace_back(id, d);
+        }
+    }
+    std::sort(direction.begin(), direction.end());
+    auto direction_of = [&direction](int p) {
+        auto it = std::lower_bound(direction.begin(), direction.end(), std::make_pair(p, -1));
+        return it != direction.end() && it->first == p ? it->second : 0;
+    };
+
+    auto functions_it = network.threshold_functions.find(s_idx);
+    const ThresholdFunctions& functions =
+        functions_it != network.threshold_functions.end() ? functions_it->second : no_rows;
+
+    std::vector<std::pair<int, double>> y_min, y_max;
+    auto add_row = [&](const std::vector<std::pair<int, double>>& terms, int big_var, double big_coef,
+                       char sense, double rhs, int order, const char* suffix) {
+        for (const auto& [var, coef] : terms) {
+            block.row_vars.push_back(var);
+            block.row_coefs.push_back(coef);
+        }
+        block.row_vars.push_back(big_var);
+        block.row_coefs.push_back(big_coef);
+        block.row_begin.push_back(block.row_vars.size());
+        block.row_senses.push_back(sense);
+        block.row_rhs.push_back(rhs);
+        if (names) block.row_names.push_back("s" + s_name + "_o" + std::to_string(order) + suffix);
+    };
+
+    for (int order = 0; order < static_cast<int>(functions.size()); ++order) {
+        int always_over = new_aux(names ? "s" + s_name + "_always_over_" + std::to_string(order) : "");
+        int always_under = new_aux(names ? "s" + s_name + "_always_under_" + std::to_string(order) : "");
+        block.always_over.push_back(always_over);
+        block.always_under.push_back(always_under);
+
+        // y_min/y_max: the row sum in the worst case for "always over" and the best case
+        // for "always under". Forced parents and fixed externals are folded into the
+        // threshold, as are the constant parts of the terms.
+        const auto& [weights, func_threshold] = functions[order];
+        double threshold = func_threshold;
+        double min_const = 0, max_const = 0;
+        y_min.clear();
+        y_max.clear();
+        int i = 0;
+        for (int p_idx = 0; p_idx < static_cast<int>(weights.size()); ++p_idx) {
+            double weight = weights[p_idx];
+            if (weight == 0) continue;
+            auto known = percolation.known_inputs.find(p_idx);
+            if (known != percolation.known_inputs.end()) {
+                threshold -= weight * known->second;
+                continue;
+            }
+            int term = i++;
+            if (p_idx >= state_size) {
+                int ext_var = 2 * free_size + (p_idx - state_size);
+                y_min.emplace_back(ext_var, weight);
+                y_max.emplace_back(ext_var, weight);
+                continue;
+            }
+            int states_var = 2 * position[p_idx];
+            int fixed_var = states_var + 1;
+            int d = direction_of(p_idx);
+
+            // Monotone inputs whose direction agrees with the weight sign are linear in
+            // states/fixed (states implies fixed); a free self input counts as on in y_min
+            // and off in y_max, whatever its weight; binate inputs keep indicators.
+            if (p_idx != s_idx && weight > 0 && d > 0) {
+                // x_min = fixed ? states : 0, x_max = fixed ? states : 1
+                y_min.emplace_back(states_var, weight);
+                y_max.emplace_back(states_var, weight);
+                y_max.emplace_back(fixed_var, -weight);
+                max_const += weight;
+            } else if (p_idx == s_idx || (weight < 0 && d < 0)) {
+                // x_min = fixed ? states : 1, x_max = fixed ? states : 0
+                y_min.emplace_back(states_var, weight);
+                y_min.emplace_back(fixed_var, -weight);
+                min_const += weight;
+                y_max.emplace_back(states_var, weight);
+            } else {
+                int x_min = new_aux(names ? "s" + s_name + "_" + std::to_string(order) + "_min_" + std::to_string(term) : "");
+                block.indicators.push_back({fixed_var, x_min, states_var, weight < 0 ? 1.0 : 0.0});
+                int x_max = new_aux(names ? "s" + s_name + "_" + std::to_string(order) + "_max_" + std::to_string(term) : "");
+                block.indicators.push_back({fixed_var, x_max, states_var, weight > 0 ? 1.0 : 0.0});
+                y_min.emplace_back(x_min, weight);
+                y_max.emplace_back(x_max, weight);
+            }
+        }
+
+        add_row(y_min, always_over, -M, GRB_LESS_EQUAL, threshold - 1 - min_const, order, "_always_over_1");
+        add_row(y_min, always_over, -M, GRB_GREATER_EQUAL, threshold - M - min_const, order, "_always_over_2");
+        add_row(y_max, always_under, M, GRB_GREATER_EQUAL, threshold - max_const, order, "_always_under_1");
+        add_row(y_max, always_under, M, GRB_LESS_EQUAL, threshold - 1 + M - max_const, order, "_always_under_2");
+    }
+    block.under_var = new_aux(names ? "under_" + s_name : "");
+    return block;
+}
+
+}
+
+ILPModel build_ilp_model(BooleanNetwork& network, int size, const PercolationResult& percolation,
+                         const std::vector<int>& branch_nodes) {
     GRBEnv env;
     GRBModel model(env);
     model.getEnv().set(GRB_IntParam_OutputFlag, 0);
 
     int state_size = network.get_state_size();
     int external_size = network.external_size;
-
-    // Create variables
-    std::vector<GRBVar> states_vars(state_size);
-    std::vector<GRBVar> externals_vars(external_size);
-    std::vector<GRBVar> fixed_vars(state_size);
-
-    for (int i = 0; i < state_size; ++i) {
-        states_vars[i] = model.addVar(0, 1, 0, GRB_BINARY, "states_" + std::to_string(i));
-        fixed_vars[i] = model.addVar(0, 1, 0, GRB_BINARY, "fixed_" + std::to_string(i));
+    const std::vector<int>& node_ids = percolation.free_states;
+    int free_size = node_ids.size();
+    bool names = enumeration_options.model_names;
+
+    // Position of every free node in states_vars/fixed_vars
+    std::vector<int> position(state_size, -1);
+    for (int i = 0; i < free_size; ++i) position[node_ids[i]] = i;
+
+    // Node blocks in parallel; large models only, since modules already build theirs concurrently
+    std::vector<NodeBlock> blocks(free_size);
+    {
+        std::atomic<int> next_node(0);
+        std::vector<std::exception_ptr> errors;
+        std::mutex errors_lock;
+        auto worker = [&]() {
+            try {
+                for (int pos = next_node++; pos < free_size; pos = next_node++) {
+                    blocks[pos] = build_node_block(network, percolation, position, pos, names);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(errors_lock);
+                errors.push_back(std::current_exception());
+            }
+        };
+        int threads = enumeration_options.threads > 0 ? enumeration_options.threads
+                                                      : static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, free_size / 256));
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool) th.join();
+        if (!errors.empty()) std::rethrow_exception(errors.front());
     }
 
+    // Variables: states/fixed pairs, externals, then the auxiliaries of each block
+    std::vector<int> aux_begin(free_size + 1, 2 * free_size + external_size);
+    for (int pos = 0; pos < free_size; ++pos) aux_begin[pos + 1] = aux_begin[pos] + blocks[pos].aux_count;
+    int var_count = aux_begin[free_size];
+
+    std::vector<double> lower(var_count, 0.0), upper(var_count, 1.0);
+    std::vector<char> types(var_count, GRB_BINARY);
     for (int i = 0; i < external_size; ++i) {
-        externals_vars[i] = model.addVar(0, 1, 0, GRB_BINARY, "external_" + std::to_string(i));
+        auto known = percolation.known_inputs.find(state_size + i);
+        if (known != percolation.known_inputs.end()) lower[2 * free_size + i] = upper[2 * free_size + i] = known->second;
+    }
+    // Static nodes are fixed (forced static nodes are already gone)
+    for (const auto& node_name : network.state_nodes_names) {
+        const Node& node = *network.nodes[node_name];
+        if (node.static_flag && position[node.id] != -1) lower[2 * position[node.id] + 1] = 1;
     }
 
-    // Main constraints
-    for (int s_idx = 0; s_idx < state_size; ++s_idx) {
-        auto node_thresholds_funcs = network.threshold_functions[s_idx];
-        int threshold_order = 1;
-
-        std::vector<GRBVar> always_over(threshold_order);
-        std::vector<GRBVar> always_under(threshold_order);
-
-        for (int order = 0; order < threshold_order; ++order) {
-            always_over[order] = model.addVar(0, 1, 0, GRB_BINARY,
-                "s" + std::to_string(s_idx) + "_always_over_" + std::to_string(order));
-            always_under[order] = model.addVar(0, 1, 0, GRB_BINARY,
-                "s" + std::to_string(s_idx) + "_always_under_" + std::to_string(order));
+    std::vector<std::string> var_names;
+    if (names) {
+        var_names.reserve(var_count);
+        for (int i = 0; i < free_size; ++i) {
+            var_names.push_back("states_" + std::to_string(node_ids[i]));
+            var_names.push_back("fixed_" + std::to_string(node_ids[i]));
+        }
+        for (int i = 0; i < external_size; ++i) var_names.push_back("external_" + std::to_string(i));
+        for (const auto& block : blocks) var_names.insert(var_names.end(), block.aux_names.begin(), block.aux_names.end());
+    }
 
-            auto [weights_dict, func_threshold] = node_thresholds_funcs;
-            std::vector<int> p_indices;
-            for(int i = 0; i < weights_dict.size(); ++i)
-            {
-                if(weights_dict[i] != 0) p_indices.push_back(i);
-            }
-            // x_min variables and constraints
-            std::vector<GRBVar> x_min(p_indices.size());
-            for (size_t i = 0; i < p_indices.size(); ++i) {
-                x_min[i] = model.addVar(0, 1, 0, GRB_BINARY,
-                    "s" + std::to_string(s_idx) + "_" + std::to_string(order) + "_min_" + std::to_string(i));
-                int p_idx = p_indices[i];
-
-                if (p_idx < state_size) {
-                    // (fixed[p_idx] == 1) => x_min[i] == states[p_idx]
-                    model.addGenConstrIndicator(fixed_vars[p_idx], 1, x_min[i] - states_vars[p_idx], GRB_EQUAL, 0.0);
-
-                    // (fixed[p_idx] == 0) => x_min[i] == (weights < 0 || p_idx == s_idx)
-                    bool target = (weights_dict.at(p_idx) < 0) || (p_idx == s_idx);
-                    model.addGenConstrIndicator(fixed_vars[p_idx], 0, x_min[i], GRB_EQUAL, target ? 1.0 : 0.0);
-                }
-            }
+    GRBVar* added_vars = model.addVars(lower.data(), upper.data(), nullptr, types.data(),
+                                       names ? var_names.data() : nullptr, var_count);
+    std::vector<GRBVar> vars(added_vars, added_vars + var_count);
+    delete[] added_vars;
 
-            // y_min constraint
-            GRBLinExpr y_min;
-            for (size_t i = 0; i < p_indices.size(); ++i) {
-                int p_idx = p_indices[i];
-                double weight = weights_dict.at(p_idx);
-                if (p_idx < state_size) {
-                    y_min += x_min[i] * weight;
-                } else {
-                    int ext_idx = p_idx - state_size;
-                    y_min += externals_vars[ext_idx] * weight;
-                }
+    std::vector<GRBVar> states_vars(free_size), fixed_vars(free_size);
+    for (int i = 0; i < free_size; ++i) {
+        states_vars[i] = vars[2 * i];
+        fixed_vars[i] = vars[2 * i + 1];
+    }
+    std::vector<GRBVar> externals_vars(vars.begin() + 2 * free_size, vars.begin() + 2 * free_size + external_size);
+    std::vector<bool> read_externals(external_size, false);
+    for (int k : node_ids) {
+        for (const auto& [weights, threshold] : network.threshold_functions.at(k)) {
+            for (int i = 0; i < external_size && state_size + i < static_cast<int>(weights.size()); ++i) {
+                if (weights[state_size + i] != 0) read_externals[i] = true;
             }
-            model.addConstr(y_min <= func_threshold - 1 + M * always_over[order],
-                "s" + std::to_string(s_idx) + "_o" + std::to_string(order) + "_always_over_1");
-            model.addConstr(y_min >= func_threshold - M * (1 - always_over[order]),
-                "s" + std::to_string(s_idx) + "_o" + std::to_string(order) + "_always_over_2");
-
-            // Similar x_max and y_max constraints would be implemented here
         }
-            GRBVar or_var = model.addVar(0, 1, 0, GRB_BINARY, "or_" + std::to_string(s_idx));
-            GRBVar or_terms[] = {always_over[0], always_under[0]};
-            model.addGenConstrOr(or_var, or_terms, 2);
-            model.addConstr(fixed_vars[s_idx] == or_var);
-            model.addConstr(states_vars[s_idx] == always_over[0]);
     }
 
-    // Static nodes constraints
-    for (const auto& node_name : network.state_nodes_names) {
-        const Node& node = *network.nodes[node_name];
-        if (node.static_flag) {
-            model.addConstr(fixed_vars[node.id] >= 1);
+    auto var_of = [&vars, &aux_begin](int pos, int ref) {
+        return vars[ref >= 0 ? ref : aux_begin[pos] - 1 - ref];
+    };
+
+    // Linear rows of every block in one call
+    size_t row_count = 0;
+    for (const auto& block : blocks) row_count += block.row_senses.size();
+    std::vector<GRBLinExpr> rows(row_count);
+    std::vector<char> senses;
+    std::vector<double> rhs;
+    std::vector<std::string> row_names;
+    senses.reserve(row_count);
+    rhs.reserve(row_count);
+    size_t row = 0;
+    std::vector<GRBVar> row_vars;
+    for (int pos = 0; pos < free_size; ++pos) {
+        const NodeBlock& block = blocks[pos];
+        for (size_t r = 0; r < block.row_senses.size(); ++r, ++row) {
+            int begin = block.row_begin[r], end = block.row_begin[r + 1];
+            row_vars.clear();
+            for (int k = begin; k < end; ++k) row_vars.push_back(var_of(pos, block.row_vars[k]));
+            rows[row].addTerms(block.row_coefs.data() + begin, row_vars.data(), end - begin);
         }
+        senses.insert(senses.end(), block.row_senses.begin(), block.row_senses.end());
+        rhs.insert(rhs.end(), block.row_rhs.begin(), block.row_rhs.end());
+        if (names) row_names.insert(row_names.end(), block.row_names.begin(), block.row_names.end());
+    }
+    delete[] model.addConstrs(rows.data(), senses.data(), rhs.data(), names ? row_names.data() : nullptr, row_count);
+
+    // On iff every row always holds, off iff some row never does. These come first so
+    // that defining_constrs[pos] == 3 * pos.
+    std::vector<int> defining_constrs(free_size);
+    std::vector<GRBVar> operands;
+    for (int pos = 0; pos < free_size; ++pos) {
+        const NodeBlock& block = blocks[pos];
+        std::string s_name = names ? std::to_string(node_ids[pos]) : std::string();
+        defining_constrs[pos] = 3 * pos;
+        operands.clear();
+        for (int ref : block.always_over) operands.push_back(var_of(pos, ref));
+        model.addGenConstrAnd(states_vars[pos], operands.data(), operands.size(), names ? "on_" + s_name : "");
+        operands.clear();
+        for (int ref : block.always_under) operands.push_back(var_of(pos, ref));
+        GRBVar under_var = var_of(pos, block.under_var);
+        model.addGenConstrOr(under_var, operands.data(), operands.size(), names ? "off_" + s_name : "");
+        GRBVar or_terms[] = {states_vars[pos], under_var};
+        model.addGenConstrOr(fixed_vars[pos], or_terms, 2, names ? "fixed_" + s_name : "");
+    }
+    // Binate inputs: (fixed == 1) => x == states, (fixed == 0) => x == target
+    for (int pos = 0; pos < free_size; ++pos) {
+        for (const auto& spec : blocks[pos].indicators) {
+            GRBVar x = var_of(pos, spec.var);
+            GRBVar fixed = var_of(pos, spec.indicator);
+            model.addGenConstrIndicator(fixed, 1, x - var_of(pos, spec.state), GRB_EQUAL, 0.0);
+            model.addGenConstrIndicator(fixed, 0, x, GRB_EQUAL, spec.target);
+        }
+    }
+
+    std::vector<GRBVar> branch_vars;
+    for (int k : branch_nodes) {
+        if (position[k] == -1) continue;
+        branch_vars.push_back(states_vars[position[k]]);
+        branch_vars.push_back(fixed_vars[position[k]]);
+    }
+    if (!branch_vars.empty()) {
+        std::vector<int> priorities(branch_vars.size(), 1);
+        model.set(GRB_IntAttr_BranchPriority, branch_vars.data(), priorities.data(), branch_vars.size());
     }
 
     // Fixed variables sum constraint
     GRBLinExpr sum_fixed;
-    for (const auto& var : fixed_vars) sum_fixed += var;
-    model.addConstr(sum_fixed == size);
+    std::vector<double> ones(free_size, 1.0);
+    sum_fixed.addTerms(ones.data(), fixed_vars.data(), free_size);
+    GRBConstr fixed_count = model.addConstr(sum_fixed, GRB_EQUAL, size, names ? "fixed_count" : "");
 
     model.update();
-    return ILPModel{std::move(model), states_vars, externals_vars, fixed_vars};
+    return ILPModel{std::move(model), states_vars, externals_vars, fixed_vars,
+                    node_ids, percolation.forced_states, fixed_count, defining_constrs, read_externals};
+}
+
+ILPModel copy_ilp_model(const ILPModel& ilp_model, const GRBEnv& env) {
+    GRBModel model(ilp_model.model, env);
+    // A copy keeps the order of variables and constraints
+    GRBVar* vars = model.getVars();
+    auto remap = [vars](const std::vector<GRBVar>& originals) {
+        std::vector<GRBVar> copied;
+        copied.reserve(originals.size());
+        for (const auto& var : originals) copied.push_back(vars[var.index()]);
+        return copied;
+    };
+    std::vector<GRBVar> states_vars = remap(ilp_model.states_vars);
+    std::vector<GRBVar> externals_vars = remap(ilp_model.externals_vars);
+    std::vector<GRBVar> fixed_vars = remap(ilp_model.fixed_vars);
+    delete[] vars;
+    GRBConstr* constrs = model.getConstrs();
+    GRBConstr fixed_count = constrs[ilp_model.fixed_count.index()];
+    delete[] constrs;
+    return ILPModel{std::move(model), states_vars, externals_vars, fixed_vars,
+                    ilp_model.node_ids, ilp_model.forced_states, fixed_count, ilp_model.defining_constrs,
+                    ilp_model.read_externals};
+}
+
+void clamp_nodes(ILPModel& ilp_model, const std::map<int, int>& values) {
+    // The rows of their functions stay in the model but no longer decide their values
+    std::vector<int> removed;
+    GRBGenConstr* gen_constrs = ilp_model.model.getGenConstrs();
+    for (size_t pos = 0; pos < ilp_model.node_ids.size(); ++pos) {
+        auto value = values.find(ilp_model.node_ids[pos]);
+        if (value == values.end()) continue;
+        int first = ilp_model.defining_constrs[pos];
+        if (first >= 0) {
+            for (int k = first; k < first + 3; ++k) {
+                ilp_model.model.remove(gen_constrs[k]);
+                removed.push_back(k);
+            }
+            ilp_model.defining_constrs[pos] = -1;
+        }
+        ilp_model.states_vars[pos].set(GRB_DoubleAttr_LB, value->second);
+        ilp_model.states_vars[pos].set(GRB_DoubleAttr_UB, value->second);
+        ilp_model.fixed_vars[pos].set(GRB_DoubleAttr_LB, 1);
+    }
+    delete[] gen_constrs;
+
+    // Later general constraints move down over the removed ones
+    std::sort(removed.begin(), removed.end());
+    for (int& first : ilp_model.defining_constrs) {
+        if (first >= 0) first -= std::lower_bound(removed.begin(), removed.end(), first) - removed.begin();
+    }
+    ilp_model.model.update();
+}
+
+std::vector<std::map<int, int>> enumerate_by_size(ILPModel& ilp_model, int max_size) {
+    std::vector<std::map<int, int>> trap_spaces;
+    bool minimal_only = enumeration_options.minimal_only;
+    for (int i = max_size; i >= 1; --i) {
+        ilp_model.fixed_count.set(GRB_DoubleAttr_RHS, i);
+        while (true) {
+            AILP_TRACE_COUNT("ilp.solves", 1);
+            if (!optimize_within_budget(ilp_model)) break;
+
+            auto stable_states = get_stable_states(ilp_model);
+            trap_spaces.push_back(stable_states);
+            // The general form stays valid when the size moves on
+            add_stable_state_constraint(ilp_model, stable_states, false);
+            if (minimal_only) {
+                add_subsumption_cut(ilp_model, stable_states, get_external_values(ilp_model));
+            }
+        }
+    }
+    return trap_spaces;
 }
 
 void add_stable_state_constraint(
-    GRBModel& model,
-    const std::vector<GRBVar>& states_vars,
-    const std::vector<GRBVar>& fixed_vars,
+    ILPModel& ilp_model,
     const std::map<int, int>& stable_states,
     bool stable_state
 ) {
+    const auto& states_vars = ilp_model.states_vars;
+    const auto& fixed_vars = ilp_model.fixed_vars;
     GRBLinExpr expr_1;
 
-    // Build expr_1: sum over stable_states entries
-    for (const auto& [i, val] : stable_states) {
-        if (val == 1) {
+    // Build expr_1: sum over stable_states entries (forced nodes are constant)
+    for (size_t i = 0; i < states_vars.size(); ++i) {
+        auto it = stable_states.find(ilp_model.node_ids[i]);
+        if (it == stable_states.end()) continue;
+        if (it->second == 1) {
             expr_1 += 1 - states_vars[i];
         } else {
             expr_1 += states_vars[i];
@@ -135,101 +448,323 @@ void add_stable_state_constraint(
     }
 
     if (stable_state) {
-        model.addConstr(expr_1 >= 1, "compair");
+        ilp_model.model.addConstr(expr_1 >= 1, "compair");
         return;
     }
 
     // Build expr_2: sum over all states
     GRBLinExpr expr_2;
-    for (int i = 0; i < states_vars.size(); ++i) {
-        if (stable_states.count(i)) {
+    for (size_t i = 0; i < states_vars.size(); ++i) {
+        if (stable_states.count(ilp_model.node_ids[i])) {
             expr_2 += 1 - fixed_vars[i];
         } else {
             expr_2 += fixed_vars[i];
         }
     }
 
-    model.addConstr(expr_1 + expr_2 >= 1, "compair");
+    ilp_model.model.addConstr(expr_1 + expr_2 >= 1, "compair");
 }
-std::map<int, int> get_stable_states(
-    GRBModel& model,
-    int state_size,
-    int external_size
+
+void add_subsumption_cut(
+    ILPModel& ilp_model,
+    const std::map<int, int>& stable_states,
+    const std::vector<int>& external_values
 ) {
-    std::map<int, int> stable_states;
-    GRBVar* all_vars = model.getVars();
+    // A candidate contains the found space iff it fixes nothing outside it, agrees on
+    // everything it fixes inside it and uses the same externals.
+    GRBLinExpr expr;
+    for (size_t i = 0; i < ilp_model.states_vars.size(); ++i) {
+        auto it = stable_states.find(ilp_model.node_ids[i]);
+        if (it == stable_states.end()) {
+            expr += ilp_model.fixed_vars[i];
+        } else if (it->second == 1) {
+            // states implies fixed, so this is 1 exactly when the node is fixed to 0
+            expr += ilp_model.fixed_vars[i] - ilp_model.states_vars[i];
+        } else {
+            expr += ilp_model.states_vars[i];
+        }
+    }
+    for (size_t j = 0; j < ilp_model.externals_vars.size() && j < external_values.size(); ++j) {
+        if (!ilp_model.read_externals[j]) continue;
+        if (external_values[j] == 1) {
+            expr += 1 - ilp_model.externals_vars[j];
+        } else {
+            expr += ilp_model.externals_vars[j];
+        }
+    }
+
+    ilp_model.model.addConstr(expr >= 1, "subsume");
+}
 
-    // Extract state values (first 'state_size' variables)
-    std::vector<int> states_val(state_size);
-    for (int i = 0; i < state_size; ++i) {
-        states_val[i] = static_cast<int>(std::round(all_vars[i].get(GRB_DoubleAttr_X)));
+void add_symmetry_breaking_constraints(ILPModel& ilp_model, const std::vector<NodePermutation>& symmetries) {
+    std::map<int, int> position;
+    for (size_t i = 0; i < ilp_model.node_ids.size(); ++i) position[ilp_model.node_ids[i]] = i;
+
+    // Lex-leader on the first moved node: code(x) = fixed + states orders free < 0 < 1,
+    // and x >=lex x o pi starts with code(x_a) >= code(x_pi(a)).
+    for (const auto& perm : symmetries) {
+        for (int a : ilp_model.node_ids) {
+            int b = perm[a];
+            if (b == a) continue;
+            if (!position.count(b)) break;
+            int pa = position[a], pb = position[b];
+            ilp_model.model.addConstr(ilp_model.fixed_vars[pa] + ilp_model.states_vars[pa]
+                                      >= ilp_model.fixed_vars[pb] + ilp_model.states_vars[pb],
+                                      "lex_" + std::to_string(a) + "_" + std::to_string(b));
+            break;
+        }
     }
+}
 
-    // Extract fixed values (starts after state_size + external_size)
-    std::vector<int> fixed_val(state_size);
-    const int fixed_start = state_size + external_size;
-    for (int i = 0; i < state_size; ++i) {
-        fixed_val[i] = static_cast<int>(std::round(all_vars[fixed_start + i].get(GRB_DoubleAttr_X)));
+std::vector<int> get_external_values(ILPModel& ilp_model) {
+    std::vector<int> external_values(ilp_model.externals_vars.size());
+    for (size_t j = 0; j < ilp_model.externals_vars.size(); ++j) {
+        external_values[j] = static_cast<int>(std::round(ilp_model.externals_vars[j].get(GRB_DoubleAttr_X)));
     }
+    return external_values;
+}
 
-    // Build stable states map
-    for (int idx = 0; idx < state_size; ++idx) {
-        if (fixed_val[idx] == 1) {
-            stable_states[idx] = states_val[idx];
+std::map<int, int> get_stable_states(ILPModel& ilp_model) {
+    std::map<int, int> stable_states = ilp_model.forced_states;
+
+    for (size_t i = 0; i < ilp_model.node_ids.size(); ++i) {
+        int fixed_val = static_cast<int>(std::round(ilp_model.fixed_vars[i].get(GRB_DoubleAttr_X)));
+        if (fixed_val == 1) {
+            stable_states[ilp_model.node_ids[i]] =
+                static_cast<int>(std::round(ilp_model.states_vars[i].get(GRB_DoubleAttr_X)));
         }
     }
 
-    delete[] all_vars;
     return stable_states;
 }
 
-SolutionObjects find_stable_states(BooleanNetwork& network) {
-    SolutionObjects solutions;
-    int state_size = network.get_state_size();
+// Whether fixing none of the free nodes is a trap space. Percolation takes a free self
+// input as either value, but the model counts it as 1 towards always holding and 0
+// towards ever holding, so e.g. a free positive self-loop cannot stay free: solve the
+// model at size 0 rather than assume it.
+bool free_space_is_trap(BooleanNetwork& network, const PercolationResult& percolation) {
+    if (percolation.free_states.empty()) return true;
+    ILPModel ilp_model = build_ilp_model(network, 0, percolation);
+    return optimize_within_budget(ilp_model);
+}
+
+std::vector<std::map<int, int>> enumerate_trap_spaces(BooleanNetwork& network,
+                                                     const PercolationResult& percolation,
+                                                     int min_size,
+                                                     const TrapSpaceSink& sink) {
+    std::vector<std::map<int, int>> trap_spaces;
+    // Spaces of trap_spaces from this index on have not been handed to the sink yet
+    size_t unsent = 0;
+    auto flush = [&]() {
+        if (sink) {
+            for (; unsent < trap_spaces.size(); ++unsent) sink(trap_spaces[unsent]);
+        }
+        unsent = trap_spaces.size();
+    };
+    // Minimal mode: every space found so far with its external values, cut from later sizes
+    std::vector<std::pair<std::map<int, int>, std::vector<int>>> found;
+    bool minimal_only = enumeration_options.minimal_only;
+    int free_size = percolation.free_states.size();
+    // Subsumption cuts only cover the spaces actually found, so minimal mode keeps every
+    // symmetric copy.
+    std::vector<NodePermutation> symmetries;
+
+    // Branch only on a feedback vertex set: natively when its 0/1/free assignments are
+    // few enough, otherwise by giving its variables priority in the ILP.
+    std::vector<int> branch_nodes;
+    if (enumeration_options.use_fvs && free_size > 0) {
+        branch_nodes = get_feedback_vertex_set(network, percolation.free_states);
+        AILP_TRACE_SCOPE(fvs_scope, "fvs_enumeration");
+        AILP_TRACE_ARG(fvs_scope, "fvs_size", static_cast<long long>(branch_nodes.size()));
+        if (enumerate_trap_spaces_fvs(network, percolation, branch_nodes, min_size, minimal_only,
+                                      enumeration_options.fvs_max_work, trap_spaces)) {
+            if (min_size == 0 && (!minimal_only || trap_spaces.empty())
+                && free_space_is_trap(network, percolation)) {
+                trap_spaces.push_back(percolation.forced_states);
+            }
+            flush();
+            return trap_spaces;
+        }
+    }
+    if (enumeration_options.break_symmetries && !minimal_only) {
+        symmetries = find_symmetries(network, percolation);
+    }
+    bool expanding = !symmetries.empty() && enumeration_options.expand_orbits;
+
+    // Iterate from the number of free nodes down; a space can only contain spaces that
+    // fix more nodes, so in minimal mode everything it contains has already been found.
+    for (int i = free_size; i >= min_size; --i) {
+        // Fixing none of the free nodes leaves the whole (percolated) space
+        if (i == 0) {
+            if ((!minimal_only || trap_spaces.empty()) && free_space_is_trap(network, percolation)) {
+                trap_spaces.push_back(percolation.forced_states);
+            }
+            flush();
+            break;
+        }
+
+        // Each size gets an even share of what is left of the enumeration budget
+        BudgetStep step(BudgetPhase::Enumeration, i - min_size + 1);
+        if (budget_exhausted(BudgetPhase::Enumeration)) {
+            note_budget_cut(BudgetPhase::Enumeration);
+            continue;
+        }
 
-    // Iterate from state_size down to 1
-    for (int i = state_size; i >= 1; --i) {
         // Build the ILP model for current size
-        ILPModel ilp_model = build_ilp_model(network, i);
-        bool fix_attractor = (i == state_size);
+        AILP_TRACE_SCOPE(build_scope, "build_ilp_model");
+        AILP_TRACE_ARG(build_scope, "size", i);
+        ILPModel ilp_model = build_ilp_model(network, i, percolation, branch_nodes);
+        bool fix_attractor = (i == free_size);
+        add_symmetry_breaking_constraints(ilp_model, symmetries);
+        for (const auto& [stable_states, external_values] : found) {
+            add_subsumption_cut(ilp_model, stable_states, external_values);
+        }
 
         // Find all solutions for current model
+        int solves = 0;
         while (true) {
-            ilp_model.model.optimize();
-
-            // Check optimization status
-            int status = ilp_model.model.get(GRB_IntAttr_Status);
-            if (status != GRB_OPTIMAL) {
-                break;
-            }
+            AILP_TRACE_SCOPE(solve_scope, "optimize");
+            AILP_TRACE_ARG(solve_scope, "size", i);
+            AILP_TRACE_COUNT("ilp.solves", 1);
+            if (solves++ > 0) AILP_TRACE_COUNT("ilp.resolves", 1);
+            if (!optimize_within_budget(ilp_model)) break;
 
             // Get and store solution
-            auto stable_states = get_stable_states(ilp_model.model, state_size, network.external_size);
-            solutions.add_solution(stable_states);
+            auto stable_states = get_stable_states(ilp_model);
+            trap_spaces.push_back(stable_states);
+            if (!expanding) flush();
 
             // Add exclusion constraint for next iteration
-            add_stable_state_constraint(
-                ilp_model.model,
-                ilp_model.states_vars,
-                ilp_model.fixed_vars,
-                stable_states,
-                fix_attractor
-            );
+            add_stable_state_constraint(ilp_model, stable_states, fix_attractor);
+            if (minimal_only) {
+                auto external_values = get_external_values(ilp_model);
+                add_subsumption_cut(ilp_model, stable_states, external_values);
+                found.emplace_back(stable_states, external_values);
+            }
+        }
+
+        // Images of a space have its size, so each size is expanded on its own
+        if (expanding) {
+            std::vector<std::map<int, int>> size_spaces(trap_spaces.begin() + unsent, trap_spaces.end());
+            trap_spaces.resize(unsent);
+            for (auto& space : expand_orbits(size_spaces, symmetries)) trap_spaces.push_back(std::move(space));
+            flush();
+        }
+    }
+    return trap_spaces;
+}
+
+std::vector<std::vector<std::map<int, int>>> enumerate_modules(BooleanNetwork& network,
+                                                              const PercolationResult& percolation,
+                                                              const std::vector<std::vector<int>>& modules,
+                                                              const std::vector<bool>& solve) {
+    std::vector<std::vector<std::map<int, int>>> module_spaces(modules.size());
+    std::vector<std::exception_ptr> errors(modules.size());
+    std::atomic<size_t> next_module(0);
+
+    auto worker = [&]() {
+        for (size_t m = next_module++; m < modules.size(); m = next_module++) {
+            if (!solve.empty() && !solve[m]) continue;
+            try {
+                // Each module is a network on its own: its parents are free members or known inputs
+                PercolationResult module_percolation;
+                module_percolation.known_inputs = percolation.known_inputs;
+                module_percolation.free_states = modules[m];
+                module_spaces[m] = enumerate_trap_spaces(network, module_percolation, 0);
+            } catch (...) {
+                errors[m] = std::current_exception();
+            }
         }
+    };
+
+    int threads = enumeration_options.threads > 0 ? enumeration_options.threads
+                                                  : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, modules.size()));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    for (const auto& e : errors) {
+        if (e) std::rethrow_exception(e);
     }
+    return module_spaces;
+}
 
-    // Handle empty case
-    if (solutions.solutions.empty()) {
-        solutions.add_solution({});
+ComponentProduct find_stable_states_product(BooleanNetwork& network,
+                                            const PercolationResult& percolation,
+                                            const std::vector<std::vector<int>>& modules) {
+    std::vector<std::vector<std::map<int, int>>> module_spaces = enumerate_modules(network, percolation, modules);
+    ComponentProduct product(percolation.forced_states);
+    for (const auto& spaces : module_spaces) product.add_component(spaces);
+    return product;
+}
+
+PercolationResult get_percolation(BooleanNetwork& network, const std::map<int, int>& fixed_externals) {
+    if (enumeration_options.percolate) return percolate_constants(network, fixed_externals);
+
+    PercolationResult percolation;
+    int state_size = network.get_state_size();
+    for (int i = 0; i < state_size; ++i) percolation.free_states.push_back(i);
+    for (const auto& [ext, v] : fixed_externals) {
+        percolation.known_inputs[state_size + ext] = v;
+    }
+    return percolation;
+}
+
+std::vector<std::map<int, int>> find_trap_spaces(BooleanNetwork& network, const PercolationResult& percolation,
+                                                 const TrapSpaceSink& sink) {
+    std::vector<std::map<int, int>> trap_spaces;
+    // With a sink the spaces only go there; the product is never flattened
+    size_t found = 0;
+    auto emit = [&](const std::map<int, int>& stable_states) {
+        ++found;
+        if (sink) {
+            sink(stable_states);
+        } else {
+            trap_spaces.push_back(stable_states);
+        }
+    };
+    // With forced nodes, fixing none of the free ones is still a proper subspace.
+    int min_size = percolation.forced_states.empty() ? 1 : 0;
+
+    std::vector<std::vector<int>> modules;
+    if (enumeration_options.decompose_modules) {
+        modules = get_network_modules(network, percolation);
     }
 
+    if (modules.size() > 1) {
+        std::cout << "Modules: " << modules.size() << std::endl;
+        ComponentProduct product = find_stable_states_product(network, percolation, modules);
+        // Same largest-first order as the monolithic enumeration
+        for (int i = product.max_fixed(); i >= min_size; --i) {
+            product.for_each_of_size(i, emit);
+        }
+    } else {
+        trap_spaces = enumerate_trap_spaces(network, percolation, min_size, sink);
+        found = trap_spaces.size();
+        if (sink) trap_spaces.clear();
+    }
+
+    // Handle empty case
+    if (found == 0) emit(percolation.forced_states);
+    return trap_spaces;
+}
+
+SolutionObjects find_stable_states(BooleanNetwork& network) {
+    AILP_TRACE_SCOPE(scope, "find_stable_states");
+    SolutionObjects solutions;
+    PercolationResult percolation = get_percolation(network, enumeration_options.fixed_externals);
+    for (const auto& stable_states : find_trap_spaces(network, percolation)) {
+        solutions.add_solution(stable_states);
+    }
     return solutions;
 }
 
 SolutionObjects find_stable_states_and_external(
     BooleanNetwork& network,
-    bool is_verify_sub_solutions = false,
-    bool is_save = false
+    bool is_verify_sub_solutions,
+    bool is_save
 )
 {
     // Print network info
@@ -240,23 +775,41 @@ SolutionObjects find_stable_states_and_external(
               << ", external dependent: " << network.external_only_depended_nodes_names.size()
               << std::endl;
 
-    SolutionObjects solutions = find_stable_states(network);
-    solutions = SpecialNodes::find_external_assignments(network, solutions);
+    start_budget();
+    SolutionObjects solutions;
+    if (pipeline_options.enabled) {
+        auto assign_externals = [&network](const std::map<int, int>& stable_states) -> SolutionObjects {
+            SolutionObjects space;
+            space.add_solution(stable_states);
+            return SpecialNodes::find_external_assignments(network, space);
+        };
+        solutions = find_and_prune_pipelined(network, assign_externals, is_verify_sub_solutions);
+    } else {
+        solutions = find_stable_states(network);
+    }
+    bool complete = !budget_cut(BudgetPhase::Enumeration);
+    if (!complete) {
+        std::cout << "Budget: enumeration cut short, keeping the trap spaces found so far" << std::endl;
+    }
 
-    // Count solutions by size
-    int size_one_count = 0;
-    int bigger_than_one_count = 0;
-    for (const auto& solution : solutions.solutions) {
-        if (solution.second.stable_nodes.size() == network.get_state_size()) {
-            size_one_count++;
-        } else if (solution.second.stable_nodes.size() < network.get_state_size()) {
-            bigger_than_one_count++;
+    if (!pipeline_options.enabled) {
+        solutions = SpecialNodes::find_external_assignments(network, solutions);
+
+        // Count solutions by size
+        int size_one_count = 0;
+        int bigger_than_one_count = 0;
+        for (const auto& solution : solutions.solutions) {
+            if (solution.second.stable_nodes.size() == network.get_state_size()) {
+                size_one_count++;
+            } else if (solution.second.stable_nodes.size() < network.get_state_size()) {
+                bigger_than_one_count++;
+            }
         }
-    }
-    std::cout << "size one solutions: " << size_one_count << std::endl;
-    std::cout << "bigger than one solutions: " << bigger_than_one_count << std::endl;
+        std::cout << "size one solutions: " << size_one_count << std::endl;
+        std::cout << "bigger than one solutions: " << bigger_than_one_count << std::endl;
 
-    remove_included_solutions(network, solutions, is_verify_sub_solutions);
+        remove_included_solutions(network, solutions, is_verify_sub_solutions);
+    }
 
     if (!network.external_only_depended_nodes_names.empty()) {
         solutions = SpecialNodes::add_external_only_dependent_to_solutions(network, solutions);
@@ -278,6 +831,8 @@ SolutionObjects find_stable_states_and_external(
     }
     std::cout << std::endl;
 
+    stop_budget();
+    solutions.complete = complete;
     return solutions;
 }
 
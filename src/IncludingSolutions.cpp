@@ -2,12 +2,20 @@
 #include <map>
 #include <set>
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <numeric>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
 #include "BooleanNetwork.h"
 #include "SolutionObjects.h"
-#include "Reachability.cpp"
+#include "IncludingSolutions.h"
+#include "Budget.h"
+#include "CheckArena.h"
+#include "Instrumentation.h"
+#include "Reachability.h"
 
 using namespace std;
 
@@ -75,191 +83,265 @@ vector<T> vector_unique(const vector<T>& input) {
         return result;
     }
 
+namespace {
+
+// Adds the edge solution -> bigger_solution when bigger_solution fixes every node of
+// solution to the same value under a compatible external assignment.
+void add_edge_if_included(SolutionObjects& solutions, const TrapSpace& solution, const TrapSpace& bigger_solution) {
+    for (const auto& [k, v] : solution.stable_nodes) {
+        auto fixed = bigger_solution.stable_nodes.find(k);
+        if (fixed == bigger_solution.stable_nodes.end() || fixed->second != v) return;
+    }
+
+    int external_id = solutions.solution_to_externals[solution.solution_id];
+    int bigger_external_id = solutions.solution_to_externals[bigger_solution.solution_id];
+    auto& edges = solutions.all_included_solutions[solution.solution_id];
+    if (external_id == bigger_external_id) {
+        edges.push_back(bigger_solution.solution_id);
+        return;
+    }
+
+    auto key = make_pair(external_id, bigger_external_id);
+    auto known = solutions.all_included_externals.find(key);
+    if (known == solutions.all_included_externals.end()) {
+        known = solutions.all_included_externals
+                    .emplace(key, get_included_external(solutions, external_id, bigger_external_id)).first;
+    }
+    if (!known->second.empty()) {
+        edges.push_back(bigger_solution.solution_id);
+    }
+}
+
+}
+
     void build_solutions_hierarchy_tree(BooleanNetwork& network, SolutionObjects& solutions) {
-        map<int, vector<int>> edges_list;
-        map<pair<int, int>, vector<vector<int>>> included_externals;
+        solutions.all_included_solutions.clear();
+        solutions.all_included_externals.clear();
 
-        vector<TrapSpace> ordered_solution;
+        vector<const TrapSpace*> ordered_solution;
         for (auto& [id, sol] : solutions.solutions) {
-            ordered_solution.push_back(sol);
+            ordered_solution.push_back(&sol);
         }
-        sort(ordered_solution.begin(), ordered_solution.end(),
-            [](const TrapSpace& a, const TrapSpace& b) {
-                return a.stable_nodes.size() < b.stable_nodes.size();
+        stable_sort(ordered_solution.begin(), ordered_solution.end(),
+            [](const TrapSpace* a, const TrapSpace* b) {
+                return a->stable_nodes.size() < b->stable_nodes.size();
             });
 
         for (size_t i = 0; i < ordered_solution.size(); ++i) {
-            auto& solution = ordered_solution[i];
-            if (solution.stable_nodes.size() == network.state_size) break;
+            const TrapSpace& solution = *ordered_solution[i];
+            if (solution.stable_nodes.size() == static_cast<size_t>(network.state_size)) break;
 
-            int external_id = solutions.solution_to_externals[solution.solution_id];
-            
             for (size_t j = i + 1; j < ordered_solution.size(); ++j) {
-                auto& bigger_solution = ordered_solution[j];
+                const TrapSpace& bigger_solution = *ordered_solution[j];
                 if (bigger_solution.stable_nodes.size() == solution.stable_nodes.size()) continue;
-
-                bool all_included = true;
-                for (auto& [k, v] : solution.stable_nodes) {
-                    if (bigger_solution.stable_nodes[k] != v) {
-                        all_included = false;
-                        break;
-                    }
-                }
-
-                if (all_included) {
-                    int bigger_external_id = solutions.solution_to_externals[bigger_solution.solution_id];
-                    if (external_id == bigger_external_id) {
-                        edges_list[solution.solution_id].push_back(bigger_solution.solution_id);
-                        continue;
-                    }
-
-                    auto key = make_pair(external_id, bigger_external_id);
-                    if (!included_externals.count(key)) {
-                        included_externals[key] = get_included_external(solutions, external_id, bigger_external_id);
-                    }
-
-                    if (!included_externals[key].empty()) {
-                        edges_list[solution.solution_id].push_back(bigger_solution.solution_id);
-                    }
-                }
+                add_edge_if_included(solutions, solution, bigger_solution);
             }
         }
+    }
 
-        solutions.all_included_solutions = edges_list;
-        solutions.all_included_externals = included_externals;
+    void add_to_solutions_hierarchy_tree(BooleanNetwork& network, SolutionObjects& solutions, int solution_id) {
+        const TrapSpace& solution = solutions.solutions.at(solution_id);
+        if (solution.stable_nodes.size() == static_cast<size_t>(network.state_size)) return;
+        for (const auto& [id, bigger_solution] : solutions.solutions) {
+            if (bigger_solution.stable_nodes.size() <= solution.stable_nodes.size()) continue;
+            add_edge_if_included(solutions, solution, bigger_solution);
+        }
     }
 
-void check_if_included(BooleanNetwork& network, SolutionObjects& solutions,  int solution_id, const vector<int>& included_ids,
-                          const vector<int>& externals, map<string, int>& done,
-                          bool is_verify_sub_solutions) {
+bool InclusionCache::find(string_view key, int& result) const {
+    lock_guard<mutex> guard(lock);
+    auto known = results.find(key);
+    if (known == results.end()) return false;
+    result = known->second;
+    return true;
+}
+
+void InclusionCache::insert(string key, int result) {
+    lock_guard<mutex> guard(lock);
+    results.emplace(move(key), result);
+}
+
+// One reachability check of the task's solution under one external assignment: 0 when
+// every state reaches an included space, 1 when one does not, -1 when abandoned.
+void check_if_included(BooleanNetwork& network, const InclusionTask& task, const vector<int>& externals,
+                       InclusionCache& done, bool is_verify_sub_solutions, int checks_left,
+                       InclusionVerdict& verdict) {
     if (!is_verify_sub_solutions) {
-        solutions.solutions[solution_id].mark_as_included_solution();
+        verdict.included = true;
         return;
     }
 
-    vector<TrapSpace> included_solutions;
-    for (int id : included_ids) {
-        included_solutions.push_back(solutions.solutions[id]);
+    BudgetStep step(BudgetPhase::Inclusion, checks_left);
+    if (budget_exhausted(BudgetPhase::Inclusion)) {
+        note_budget_cut(BudgetPhase::Inclusion);
+        verdict.mark_verification(VerificationStatus::SkippedForBudget);
+        return;
     }
 
-    auto& stable_nodes = solutions.solutions[solution_id].stable_nodes;
-    auto exploration_functions = get_reduced_threshold_functions(
-        network, stable_nodes, externals, included_solutions);
-
-    string key;
-    for (auto& [k, v] : exploration_functions) {
-        key += to_string(k) + ":";
-        for (auto& [f, t] : v) {
-            key += "(";
-            for (auto& [i, w] : f) key += to_string(i) + ",";
-            key += ")" + to_string(t);
+    // Everything the check builds besides its result lives until the end of this call
+    CheckArena arena;
+    auto system = get_reduced_threshold_functions(
+        network, task.solution.stable_nodes, externals, task.included_solutions, arena.resource());
+
+    pmr::string key(arena.resource());
+    auto append = [&key](const vector<int>& values) {
+        char digits[16];
+        for (int v : values) {
+            int length = snprintf(digits, sizeof(digits), "%d,", v);
+            key.append(digits, length);
         }
+        key += "|";
+    };
+    append(system.node_ids);
+    append(system.row_begin);
+    append(system.weights);
+    append(system.thresholds);
+    // The answer also depends on the included spaces, in any order
+    vector<vector<int>> cubes;
+    for (const auto& included : task.included_solutions) {
+        cubes.push_back(get_included_solution_cube(included, system.node_ids));
     }
-
-    if (done.count(key)) {
-        if (done[key] <= 0) {
-            solutions.solutions[solution_id].mark_as_included_solution();
+    sort(cubes.begin(), cubes.end());
+    for (const auto& cube : cubes) append(cube);
+
+    // -1 means the check was abandoned; keep the solution rather than guess.
+    int res;
+    if (done.find(string_view(key), res)) {
+        if (res == 0) {
+            verdict.included = true;
+        } else if (res < 0) {
+            verdict.mark_verification(VerificationStatus::Unverified);
         }
         return;
     }
 
-    int res = check_if_reachable(solutions.solutions[solution_id],
-                                             included_solutions, exploration_functions);
-    done[key] = res;
-
-    if (res <= 0) {
-        solutions.solutions[solution_id].mark_as_included_solution();
+    // Cheap random trajectories first; the exhaustive check only runs when they are inconclusive.
+    auto outcome = sample_reachability(task.included_solutions, system);
+    if (outcome == SamplingOutcome::TrapFound) {
+        res = 1;
+    } else if (outcome == SamplingOutcome::AllReached && reachability_options.trust_sampling) {
+        res = 0;
+    } else {
+        res = check_if_reachable(task.solution, task.included_solutions, system);
     }
-}
 
-    void remove_included_solutions(BooleanNetwork& network, SolutionObjects& solutions, bool is_verify_sub_solutions) {
-        int original_solution_size = solutions.solutions.size();
-        build_solutions_hierarchy_tree(network, solutions);
+    // A check the budget stopped may well finish in a later run; don't cache it
+    if (res < 0 && budget_exhausted(BudgetPhase::Inclusion)) {
+        note_budget_cut(BudgetPhase::Inclusion);
+        verdict.mark_verification(VerificationStatus::SkippedForBudget);
+        return;
+    }
+    done.insert(string(key), res);
 
-        map<string, int> done;
+    if (res == 0) {
+        verdict.included = true;
+    } else if (res < 0) {
+        verdict.mark_verification(VerificationStatus::Unverified);
+    }
+}
 
-        for (auto& [solution_id, included_ids] : solutions.all_included_solutions) {
-            if (included_ids.empty()) continue;
+InclusionTask make_inclusion_task(BooleanNetwork& network, SolutionObjects& solutions, int solution_id,
+                                  bool is_verify_sub_solutions) {
+    const vector<int>& included_ids = solutions.all_included_solutions.at(solution_id);
+    InclusionTask task{solutions.solutions.at(solution_id),
+                       solutions.external_assignments[solutions.solution_to_externals[solution_id]],
+                       {}, {}, {}};
 
-            int external_id = solutions.solution_to_externals[solution_id];
-            auto& solution = solutions.solutions[solution_id];
+    // Copied once per solution rather than once per external key
+    if (is_verify_sub_solutions) {
+        for (int id : included_ids) task.included_solutions.push_back(solutions.solutions.at(id));
+    }
 
-            vector<int> not_stable_state;
-            for (int i = 0; i < network.state_size; ++i) {
-                if (!solution.stable_nodes.count(i)) {
-                    not_stable_state.push_back(i);
-                }
-            }
+    for (int s_id : included_ids) {
+        auto map_key = make_pair(s_id, solution_id);
+        auto known = solutions.all_included_externals.find(map_key);
+        if (known != solutions.all_included_externals.end()) task.included_externals.push_back(known->second);
+    }
 
-            set<int> not_empty_externals;
-            for (int i : not_stable_state) {
-                for (auto& [f, t] : network.threshold_functions[i]) {
-                    for (auto& [k, v] : f) {
-                        if (k >= network.state_size) {
-                            not_empty_externals.insert(k - network.state_size);
-                        }
-                    }
+    set<int> not_empty_externals;
+    for (int i = 0; i < network.state_size; ++i) {
+        if (task.solution.stable_nodes.count(i)) continue;
+        auto functions = network.threshold_functions.find(i);
+        if (functions == network.threshold_functions.end()) continue;
+        for (const auto& [weights, threshold] : functions->second) {
+            for (size_t k = network.state_size; k < weights.size(); ++k) {
+                if (weights[k] != 0) {
+                    not_empty_externals.insert(k - network.state_size);
                 }
             }
+        }
+    }
+    task.not_empty_externals.assign(not_empty_externals.begin(), not_empty_externals.end());
+    return task;
+}
 
-            vector<int> not_empty_ext_vec(not_empty_externals.begin(), not_empty_externals.end());
-            sort(not_empty_ext_vec.begin(), not_empty_ext_vec.end());
-
-            auto& external_list = solutions.external_assignments[external_id];
+InclusionVerdict check_inclusion_task(BooleanNetwork& network, const InclusionTask& task, InclusionCache& done,
+                                      bool is_verify_sub_solutions, int checks_left) {
+    InclusionVerdict verdict;
+    const auto& not_empty_ext_vec = task.not_empty_externals;
 
-            if (not_empty_ext_vec.empty()) {
-                check_if_included(network, solutions, solution_id, included_ids, {}, done, is_verify_sub_solutions);
-                continue;
-            }
+    if (not_empty_ext_vec.empty()) {
+        check_if_included(network, task, {}, done, is_verify_sub_solutions, checks_left, verdict);
+        return verdict;
+    }
 
-            map<vector<int>, vector<int>> unique_externals;
-            for (size_t i = 0; i < external_list.size(); ++i) {
-                vector<int> key;
-                for (int ext : not_empty_ext_vec) {
-                    key.push_back(external_list[i][ext]);
-                }
-                unique_externals[key].push_back(i);
-            }
+    map<vector<int>, vector<int>> unique_externals;
+    for (size_t i = 0; i < task.external_list.size(); ++i) {
+        vector<int> key;
+        for (int ext : not_empty_ext_vec) {
+            key.push_back(task.external_list[i][ext]);
+        }
+        unique_externals[key].push_back(i);
+    }
 
-            vector<vector<int>> not_included_externals;
-            for (auto& [key, indices] : unique_externals) {
-                bool found = false;
-                for (int s_id : included_ids) {
-                    auto map_key = make_pair(s_id, solution_id);
-                    if (!solutions.all_included_externals.count(map_key)) continue;
-
-                    auto& included_external = solutions.all_included_externals[map_key];
-                    for (auto& ext : included_external) {
-                        vector<int> ext_key;
-                        for (int idx : not_empty_ext_vec) {
-                            ext_key.push_back(ext[idx]);
-                        }
-                        if (ext_key == key) {
-                            found = true;
-                            break;
-                        }
-                    }
-                    if (found) break;
+    for (auto& [key, indices] : unique_externals) {
+        bool found = false;
+        for (const auto& included_external : task.included_externals) {
+            for (auto& ext : included_external) {
+                vector<int> ext_key;
+                for (int idx : not_empty_ext_vec) {
+                    ext_key.push_back(ext[idx]);
                 }
-
-                if (!found) {
-                    for (int idx : indices) {
-                        not_included_externals.push_back(external_list[idx]);
-                    }
-                } else {
-                    check_if_included(network, solutions, solution_id, included_ids, key, done, is_verify_sub_solutions);
+                if (ext_key == key) {
+                    found = true;
+                    break;
                 }
             }
+            if (found) break;
+        }
 
-            if (!not_included_externals.empty() && not_included_externals.size() < external_list.size()) {
-                // Create new solution
-                int new_sol_id = solutions.add_solution(solution.stable_nodes);
-                int new_ext_id = solutions.add_externals_assignments(not_included_externals);
-                solutions.update_external_to_solution(new_sol_id, new_ext_id);
-                cout << "New solution: " << solution_id << " ----> " << new_sol_id << endl;
+        if (!found) {
+            for (int idx : indices) {
+                verdict.not_included_externals.push_back(task.external_list[idx]);
             }
+        } else {
+            // Externals the free nodes do not read stay 0; they drop out of the reduction.
+            vector<int> external(network.external_size, 0);
+            for (size_t j = 0; j < not_empty_ext_vec.size(); ++j) {
+                external[not_empty_ext_vec[j]] = key[j];
+            }
+            check_if_included(network, task, external, done, is_verify_sub_solutions, checks_left, verdict);
         }
+    }
+    return verdict;
+}
+
+void apply_inclusion_verdict(SolutionObjects& solutions, const InclusionTask& task, const InclusionVerdict& verdict) {
+    int solution_id = task.solution.solution_id;
+    auto& solution = solutions.solutions.at(solution_id);
+    if (verdict.included) solution.mark_as_included_solution();
+    solution.mark_verification(verdict.verification);
+
+    if (!verdict.not_included_externals.empty() && verdict.not_included_externals.size() < task.external_list.size()) {
+        // Create new solution
+        int new_sol_id = solutions.add_solution(task.solution.stable_nodes);
+        int new_ext_id = solutions.add_externals_assignments(verdict.not_included_externals);
+        solutions.update_external_to_solution(new_sol_id, new_ext_id);
+        cout << "New solution: " << solution_id << " ----> " << new_sol_id << endl;
+    }
+}
 
+void drop_included_solutions(SolutionObjects& solutions, int original_solution_size) {
         // Remove marked solutions
         vector<int> to_remove;
         for (auto& [id, sol] : solutions.solutions) {
@@ -272,5 +354,45 @@ void check_if_included(BooleanNetwork& network, SolutionObjects& solutions,  int
         }
 
         cout << "Num of solutions: " << solutions.solutions.size() << " / " << original_solution_size << endl;
+        int unverified = 0, skipped = 0;
+        for (auto& [id, sol] : solutions.solutions) {
+            if (sol.verification == VerificationStatus::Unverified) ++unverified;
+            if (sol.verification == VerificationStatus::SkippedForBudget) ++skipped;
+        }
+        if (unverified > 0 || skipped > 0) {
+            cout << "Verification: " << unverified << " unverified, " << skipped
+                 << " skipped for budget" << endl;
+        }
+        if (sampling_stats.checks > 0) {
+            cout << "Sampling: checks " << sampling_stats.checks
+                 << ", traps " << sampling_stats.traps_found
+                 << ", all reached " << sampling_stats.all_reached
+                 << ", inconclusive " << sampling_stats.inconclusive
+                 << ", hits " << sampling_stats.hits
+                 << ", misses " << sampling_stats.misses << endl;
+        }
+}
+
+    void remove_included_solutions(BooleanNetwork& network, SolutionObjects& solutions, bool is_verify_sub_solutions) {
+        AILP_TRACE_SCOPE(scope, "remove_included_solutions");
+        int original_solution_size = solutions.solutions.size();
+        build_solutions_hierarchy_tree(network, solutions);
+
+        InclusionCache done;
+
+        // Solutions still to check, for splitting what is left of the budget between them
+        vector<int> to_check;
+        for (auto& [solution_id, included_ids] : solutions.all_included_solutions) {
+            if (!included_ids.empty()) to_check.push_back(solution_id);
+        }
+
+        for (size_t c = 0; c < to_check.size(); ++c) {
+            InclusionTask task = make_inclusion_task(network, solutions, to_check[c], is_verify_sub_solutions);
+            InclusionVerdict verdict = check_inclusion_task(network, task, done, is_verify_sub_solutions,
+                                                            to_check.size() - c);
+            apply_inclusion_verdict(solutions, task, verdict);
+        }
+
+        drop_included_solutions(solutions, original_solution_size);
     }
 
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "IncrementalAnalysis.h"
+#include "ILPModelBuilder.h"
+#include "ModularDecomposition.h"
+#include "Percolation.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+const char* const snapshot_version = "ailp-snapshot 1";
+
+// Threshold row over input names: (name, weight) for every non-zero weight
+using NamedRow = pair<vector<pair<string, int>>, int>;
+
+struct SnapshotNode {
+    string expr;
+    vector<NamedRow> rows;
+};
+
+struct Snapshot {
+    string options;
+    int max_threshold_order = 0;
+    map<string, SnapshotNode> nodes;
+    // Module signature (its member and input lines) -> its trap spaces by node name
+    map<string, vector<map<string, int>>> modules;
+};
+
+// Options that change which trap spaces a module has. The threshold order is one of
+// them: the rows a node gets decide how its free inputs are bounded.
+string module_options(int max_threshold_order) {
+    return "max_threshold_order=" + to_string(max_threshold_order)
+         + " minimal_only=" + to_string(enumeration_options.minimal_only)
+         + " break_symmetries=" + to_string(enumeration_options.break_symmetries)
+         + " expand_orbits=" + to_string(enumeration_options.expand_orbits);
+}
+
+string format_space(const map<string, int>& space) {
+    if (space.empty()) return "-";
+    string out;
+    for (const auto& [name, v] : space) {
+        if (!out.empty()) out += ",";
+        out += name + "=" + to_string(v);
+    }
+    return out;
+}
+
+// `name=v,...`, `-` for the empty space; false when malformed
+bool parse_assignments(const string& text, vector<pair<string, int>>& assignments) {
+    assignments.clear();
+    if (text == "-") return true;
+    stringstream entries(text);
+    string entry;
+    while (getline(entries, entry, ',')) {
+        size_t eq = entry.rfind('=');
+        if (eq == string::npos || eq == 0) return false;
+        try {
+            assignments.emplace_back(entry.substr(0, eq), stoi(entry.substr(eq + 1)));
+        } catch (const exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Empty when the file is missing; a malformed snapshot is ignored with a warning
+Snapshot read_snapshot(const string& path) {
+    Snapshot snapshot;
+    ifstream in(path);
+    if (!in.is_open()) return snapshot;
+
+    string line;
+    if (!getline(in, line) || line != snapshot_version) {
+        cerr << "Ignoring snapshot " << path << ": unknown format" << endl;
+        return snapshot;
+    }
+
+    SnapshotNode* node = nullptr;
+    string signature;
+    vector<map<string, int>>* spaces = nullptr;
+    vector<pair<string, int>> assignments;
+    int line_number = 1;
+    while (getline(in, line)) {
+        ++line_number;
+        size_t space_at = line.find(' ');
+        string kind = line.substr(0, space_at);
+        string rest = space_at == string::npos ? "" : line.substr(space_at + 1);
+        bool ok = true;
+
+        if (kind == "options") {
+            snapshot.options = rest;
+        } else if (kind == "order") {
+            snapshot.max_threshold_order = atoi(rest.c_str());
+        } else if (kind == "node") {
+            size_t tab = rest.find('\t');
+            ok = tab != string::npos;
+            if (ok) {
+                node = &snapshot.nodes[rest.substr(0, tab)];
+                node->expr = rest.substr(tab + 1);
+            }
+        } else if (kind == "row") {
+            size_t tab = rest.find('\t');
+            ok = node && tab != string::npos && parse_assignments(rest.substr(tab + 1), assignments);
+            if (ok) node->rows.emplace_back(assignments, atoi(rest.substr(0, tab).c_str()));
+        } else if (kind == "member" || kind == "input") {
+            signature += line + "\n";
+            spaces = nullptr;
+        } else if (kind == "space") {
+            if (!spaces) spaces = &snapshot.modules[signature];
+            ok = parse_assignments(rest, assignments);
+            if (ok) spaces->emplace_back(assignments.begin(), assignments.end());
+        } else if (kind == "end") {
+            if (!spaces) snapshot.modules[signature];
+            signature.clear();
+            spaces = nullptr;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            cerr << "Ignoring snapshot " << path << ": malformed line " << line_number << endl;
+            return Snapshot();
+        }
+    }
+    return snapshot;
+}
+
+// Written next to the old one and renamed over it, so an interrupted run keeps the old snapshot
+bool write_snapshot(const string& path, const Snapshot& snapshot) {
+    string temporary = path + ".tmp";
+    {
+        ofstream out(temporary);
+        if (!out.is_open()) return false;
+        out << snapshot_version << "\n";
+        out << "options " << snapshot.options << "\n";
+        out << "order " << snapshot.max_threshold_order << "\n";
+        for (const auto& [name, node] : snapshot.nodes) {
+            out << "node " << name << "\t" << node.expr << "\n";
+            for (const auto& [weights, threshold] : node.rows) {
+                map<string, int> named(weights.begin(), weights.end());
+                out << "row " << threshold << "\t" << format_space(named) << "\n";
+            }
+        }
+        for (const auto& [signature, spaces] : snapshot.modules) {
+            out << signature;
+            for (const auto& space : spaces) out << "space " << format_space(space) << "\n";
+            out << "end\n";
+        }
+        if (!out) return false;
+    }
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+vector<NamedRow> name_rows(const BooleanNetwork& network, const ThresholdFunctions& functions) {
+    vector<NamedRow> rows;
+    for (const auto& [weights, threshold] : functions) {
+        vector<pair<string, int>> named;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            if (weights[i] != 0) named.emplace_back(network.index_to_name[i], weights[i]);
+        }
+        rows.emplace_back(move(named), threshold);
+    }
+    return rows;
+}
+
+// False when a row reads an input the network no longer has
+bool number_rows(const BooleanNetwork& network, const vector<NamedRow>& rows, ThresholdFunctions& functions) {
+    const int input_size = network.state_size + network.external_size;
+    functions.clear();
+    for (const auto& [named, threshold] : rows) {
+        vector<int> weights(input_size, 0);
+        for (const auto& [name, w] : named) {
+            auto node = network.nodes.find(name);
+            if (node == network.nodes.end()) return false;
+            int k = node->second->id;
+            if (k < 0 || k >= input_size || network.index_to_name[k] != name) return false;
+            weights[k] = w;
+        }
+        functions.emplace_back(move(weights), threshold);
+    }
+    return true;
+}
+
+// Copies the rows of every state node whose rule is unchanged and synthesizes the rest
+int synthesize_changed_nodes(BooleanNetwork& network, const Snapshot& previous, int max_threshold_order) {
+    unordered_set<string> changed;
+    for (const auto& name : network.state_nodes_names) {
+        auto& node = *network.nodes.at(name);
+        auto known = previous.nodes.find(name);
+        bool reuse = previous.max_threshold_order == max_threshold_order && known != previous.nodes.end()
+                  && known->second.expr == node.expr && number_rows(network, known->second.rows, node.threshold);
+        if (!reuse) changed.insert(name);
+    }
+    network.synthesize_threshold_functions(changed, max_threshold_order);
+    network.get_threshold_functions();
+    network.compute_unateness();
+    return changed.size();
+}
+
+// The lines a module's trap spaces depend on: the rules of its members and the known
+// inputs they read (`-` for externals left free)
+string module_signature(const BooleanNetwork& network, const PercolationResult& percolation,
+                        const vector<int>& module) {
+    set<int> members(module.begin(), module.end());
+    set<int> inputs;
+    for (int k : module) {
+        for (const auto& [weights, threshold] : network.threshold_functions.at(k)) {
+            for (size_t i = 0; i < weights.size(); ++i) {
+                if (weights[i] != 0 && !members.count(i)) inputs.insert(i);
+            }
+        }
+    }
+
+    map<string, string> lines;
+    for (int k : members) {
+        const string& name = network.index_to_name[k];
+        lines["member " + name] = "member " + name + "\t" + network.nodes.at(name)->expr + "\n";
+    }
+    for (int i : inputs) {
+        const string& name = network.index_to_name[i];
+        auto known = percolation.known_inputs.find(i);
+        string value = known == percolation.known_inputs.end() ? "-" : to_string(known->second);
+        lines["input " + name] = "input " + name + "=" + value + "\n";
+    }
+
+    string signature;
+    for (const auto& [key, line] : lines) signature += line;
+    return signature;
+}
+
+}
+
+IncrementalAnalysisResult analyze_incrementally(BooleanNetwork& network, const string& rules_path,
+                                                const string& snapshot_path, int max_threshold_order) {
+    AILP_TRACE_SCOPE(scope, "analyze_incrementally");
+    IncrementalAnalysisResult result;
+    Snapshot previous = read_snapshot(snapshot_path);
+
+    if (!network.parse(rules_path)) {
+        throw invalid_argument("cannot parse " + rules_path);
+    }
+    network.updated_network();
+    result.state_nodes = network.state_size;
+    result.synthesized_nodes = synthesize_changed_nodes(network, previous, max_threshold_order);
+
+    PercolationResult percolation = get_percolation(network, enumeration_options.fixed_externals);
+    vector<vector<int>> modules;
+    if (enumeration_options.decompose_modules) modules = get_network_modules(network, percolation);
+    if (modules.empty() && !percolation.free_states.empty()) modules.push_back(percolation.free_states);
+    result.modules = modules.size();
+
+    // Reuse a module's spaces only when the options that shape them are unchanged too
+    Snapshot next;
+    next.options = module_options(max_threshold_order);
+    next.max_threshold_order = max_threshold_order;
+    bool reuse_modules = previous.options == next.options;
+
+    vector<string> signatures;
+    vector<bool> solve(modules.size(), true);
+    vector<vector<map<int, int>>> module_spaces(modules.size());
+    for (size_t m = 0; m < modules.size(); ++m) {
+        signatures.push_back(module_signature(network, percolation, modules[m]));
+        auto known = previous.modules.find(signatures[m]);
+        if (!reuse_modules || known == previous.modules.end()) continue;
+        solve[m] = false;
+        for (const auto& space : known->second) {
+            map<int, int> numbered;
+            for (const auto& [name, v] : space) numbered[network.nodes.at(name)->id] = v;
+            module_spaces[m].push_back(move(numbered));
+        }
+    }
+    result.enumerated_modules = count(solve.begin(), solve.end(), true);
+    if (result.enumerated_modules > 0) {
+        auto solved = enumerate_modules(network, percolation, modules, solve);
+        for (size_t m = 0; m < modules.size(); ++m) {
+            if (solve[m]) module_spaces[m] = move(solved[m]);
+        }
+    }
+
+    // Same combination and order as find_trap_spaces
+    int min_size = percolation.forced_states.empty() ? 1 : 0;
+    ComponentProduct product(percolation.forced_states);
+    for (const auto& spaces : module_spaces) product.add_component(spaces);
+    for (int i = product.max_fixed(); i >= min_size; --i) {
+        product.for_each_of_size(i, [&result](const map<int, int>& stable_states) {
+            result.trap_spaces.push_back(stable_states);
+        });
+    }
+    if (result.trap_spaces.empty()) result.trap_spaces.push_back(percolation.forced_states);
+
+    for (const auto& name : network.state_nodes_names) {
+        const auto& node = *network.nodes.at(name);
+        next.nodes[name] = {node.expr, name_rows(network, node.threshold)};
+    }
+    for (size_t m = 0; m < modules.size(); ++m) {
+        auto& spaces = next.modules[signatures[m]];
+        for (const auto& space : module_spaces[m]) {
+            map<string, int> named;
+            for (const auto& [k, v] : space) named[network.index_to_name[k]] = v;
+            spaces.push_back(move(named));
+        }
+    }
+    if (!write_snapshot(snapshot_path, next)) {
+        cerr << "Cannot write snapshot " << snapshot_path << endl;
+    }
+
+    cout << "Incremental: synthesized " << result.synthesized_nodes << " / " << result.state_nodes
+         << " nodes, enumerated " << result.enumerated_modules << " / " << result.modules << " modules" << endl;
+    return result;
+}
@@ -0,0 +1,176 @@
+#include "Instrumentation.h"
+
+#ifdef AILP_INSTRUMENTATION
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sys/resource.h>
+
+using namespace std;
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    long long start_us;
+    long long duration_us;
+    long long peak_rss_kb;
+    int thread;
+    vector<pair<string, string>> args;
+};
+
+struct TraceLog {
+    mutex lock;
+    chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    vector<TraceEvent> events;
+    map<string, long long> counters;
+};
+
+TraceLog& trace_log() {
+    static TraceLog log;
+    return log;
+}
+
+int trace_thread_id() {
+    static atomic<int> next_id(0);
+    thread_local int id = next_id++;
+    return id;
+}
+
+long long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;   // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+string json_string(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+}
+
+TraceScope::TraceScope(const char* name) : name(name) {
+    trace_log();   // the epoch must not come after the first start time
+    start = chrono::steady_clock::now();
+}
+
+TraceScope::~TraceScope() {
+    auto end = chrono::steady_clock::now();
+    TraceLog& log = trace_log();
+    TraceEvent event{name,
+                     chrono::duration_cast<chrono::microseconds>(start - log.epoch).count(),
+                     chrono::duration_cast<chrono::microseconds>(end - start).count(),
+                     peak_rss_kb(),
+                     trace_thread_id(),
+                     move(args)};
+    lock_guard<mutex> guard(log.lock);
+    log.events.push_back(move(event));
+}
+
+void TraceScope::arg(const char* key, long long value) {
+    args.emplace_back(key, to_string(value));
+}
+
+void TraceScope::arg(const char* key, const string& value) {
+    args.emplace_back(key, json_string(value));
+}
+
+void trace_count(const char* name, long long delta) {
+    TraceLog& log = trace_log();
+    lock_guard<mutex> guard(log.lock);
+    log.counters[name] += delta;
+}
+
+bool write_trace_summary(const string& path) {
+    struct PhaseTotals {
+        long long calls = 0, total_us = 0, max_us = 0, peak_rss_kb = 0;
+    };
+    TraceLog& log = trace_log();
+    lock_guard<mutex> guard(log.lock);
+
+    map<string, PhaseTotals> phases;
+    for (const auto& e : log.events) {
+        auto& p = phases[e.name];
+        p.calls++;
+        p.total_us += e.duration_us;
+        p.max_us = max(p.max_us, e.duration_us);
+        p.peak_rss_kb = max(p.peak_rss_kb, e.peak_rss_kb);
+    }
+
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "{\n  \"phases\": {";
+    bool first = true;
+    for (const auto& [name, p] : phases) {
+        out << (first ? "\n" : ",\n") << "    " << json_string(name) << ": {\"calls\": " << p.calls
+            << ", \"total_us\": " << p.total_us << ", \"max_us\": " << p.max_us
+            << ", \"peak_rss_kb\": " << p.peak_rss_kb << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"counters\": {";
+    first = true;
+    for (const auto& [name, value] : log.counters) {
+        out << (first ? "\n" : ",\n") << "    " << json_string(name) << ": " << value;
+        first = false;
+    }
+    out << "\n  }\n}\n";
+    return static_cast<bool>(out);
+}
+
+bool write_chrome_trace(const string& path) {
+    TraceLog& log = trace_log();
+    lock_guard<mutex> guard(log.lock);
+
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    long long last_us = 0;
+    for (const auto& e : log.events) {
+        out << (first ? "\n" : ",\n") << "{\"name\": " << json_string(e.name)
+            << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << e.thread
+            << ", \"ts\": " << e.start_us << ", \"dur\": " << e.duration_us
+            << ", \"args\": {\"peak_rss_kb\": " << e.peak_rss_kb;
+        for (const auto& [key, value] : e.args) out << ", " << json_string(key) << ": " << value;
+        out << "}}";
+        first = false;
+        last_us = max(last_us, e.start_us + e.duration_us);
+    }
+    // Counters are totals, shown once at the end of the trace
+    for (const auto& [name, value] : log.counters) {
+        out << (first ? "\n" : ",\n") << "{\"name\": " << json_string(name)
+            << ", \"ph\": \"C\", \"pid\": 1, \"ts\": " << last_us
+            << ", \"args\": {\"value\": " << value << "}}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+void reset_trace() {
+    TraceLog& log = trace_log();
+    lock_guard<mutex> guard(log.lock);
+    log.events.clear();
+    log.counters.clear();
+    log.epoch = chrono::steady_clock::now();
+}
+
+#endif // AILP_INSTRUMENTATION
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "ModularDecomposition.h"
+
+using namespace std;
+
+namespace {
+
+int find_root(vector<int>& parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+void unite(vector<int>& parent, int a, int b) {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a != b) parent[max(a, b)] = min(a, b);
+}
+
+}
+
+vector<vector<int>> get_network_modules(const BooleanNetwork& network,
+                                        const PercolationResult& percolation) {
+    const int state_size = network.state_size;
+    const int input_size = state_size + network.external_size;
+
+    // Free state nodes and free externals share one union-find; known inputs are constants.
+    vector<bool> is_free(input_size, true);
+    for (const auto& [i, v] : percolation.known_inputs) {
+        if (i < input_size) is_free[i] = false;
+    }
+    vector<int> parent(input_size);
+    iota(parent.begin(), parent.end(), 0);
+
+    for (int k : percolation.free_states) {
+        auto it = network.threshold_functions.find(k);
+        if (it == network.threshold_functions.end()) continue;
+        for (const auto& [weights, threshold] : it->second) {
+            for (size_t i = 0; i < weights.size() && static_cast<int>(i) < input_size; ++i) {
+                if (weights[i] != 0 && is_free[i]) unite(parent, k, i);
+            }
+        }
+    }
+
+    map<int, vector<int>> modules;
+    for (int k : percolation.free_states) modules[find_root(parent, k)].push_back(k);
+
+    vector<vector<int>> result;
+    for (auto& [root, nodes] : modules) result.push_back(move(nodes));
+    sort(result.begin(), result.end());
+    return result;
+}
+
+ComponentProduct::ComponentProduct(map<int, int> base) : base(move(base)) {}
+
+void ComponentProduct::add_component(const vector<map<int, int>>& trap_spaces) {
+    map<int, vector<map<int, int>>> by_size;
+    for (const auto& t : trap_spaces) by_size[t.size()].push_back(t);
+    components.push_back(move(by_size));
+}
+
+int ComponentProduct::max_fixed() const {
+    int total = 0;
+    for (const auto& c : components) {
+        if (!c.empty()) total += c.rbegin()->first;
+    }
+    return total;
+}
+
+uint64_t ComponentProduct::size() const {
+    const uint64_t limit = numeric_limits<uint64_t>::max();
+    uint64_t total = 1;
+    for (const auto& c : components) {
+        uint64_t count = 0;
+        for (const auto& [fixed, spaces] : c) count += spaces.size();
+        if (count == 0) return 0;
+        total = total > limit / count ? limit : total * count;
+    }
+    return total;
+}
+
+void ComponentProduct::for_each_of_size(int fixed, const function<void(const map<int, int>&)>& visit) const {
+    const int n = components.size();
+    // Fewest/most nodes the modules from i onwards can fix.
+    vector<int> suffix_min(n + 1, 0), suffix_max(n + 1, 0);
+    for (int i = n - 1; i >= 0; --i) {
+        if (components[i].empty()) return;
+        suffix_min[i] = suffix_min[i + 1] + components[i].begin()->first;
+        suffix_max[i] = suffix_max[i + 1] + components[i].rbegin()->first;
+    }
+
+    map<int, int> current = base;
+    function<void(int, int)> combine = [&](int i, int remaining) {
+        if (i == n) {
+            if (remaining == 0) visit(current);
+            return;
+        }
+        for (const auto& [size, spaces] : components[i]) {
+            int rest = remaining - size;
+            if (rest < suffix_min[i + 1]) break;
+            if (rest > suffix_max[i + 1]) continue;
+            for (const auto& t : spaces) {
+                current.insert(t.begin(), t.end());
+                combine(i + 1, rest);
+                for (const auto& [k, v] : t) current.erase(k);
+            }
+        }
+    };
+    combine(0, fixed);
+}
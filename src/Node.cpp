@@ -1,6 +1,8 @@
 #include "Node.h"
 #include "BoolExprEvaluator.h"
 #include "gurobi_c++.h"
+#include "Instrumentation.h"
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <regex>
@@ -13,6 +15,11 @@
 #include <symengine/visitor.h>
 
 
+// Orders above 1 need an indicator per false point and row, so wider nodes go from a
+// single row straight to the clause fallback; every order also gets a time limit.
+const int MULTI_ROW_MAX_INPUTS = 8;
+const double ORDER_TIME_LIMIT = 10.0;
+
 class SymbolCollector : public SymEngine::BaseVisitor<SymbolCollector> {
 public:
     std::set<std::string> symbols;
@@ -128,81 +135,137 @@ SymEngine::RCP<const SymEngine::Basic> Node::assign_values_to_boolean_function(c
 
 
 
-void Node::solveThresholdFunction(int networkSize, const std::unordered_map<std::string, int>& nameToId) {
+void Node::solveThresholdFunction(int networkSize, const std::unordered_map<std::string, int>& nameToId, int max_order) {
     std::vector<std::string> involvedVars;
-    for (const auto& [name, id] : nameToId) {
-        if (expr.find(name) != std::string::npos)
+    for (const auto& name : getParents()) {
+        if (nameToId.count(name))
             involvedVars.push_back(name);
     }
+    std::sort(involvedVars.begin(), involvedVars.end());
 
     int numInputs = involvedVars.size();
     int numCombinations = 1 << numInputs;
 
+    // Truth table over the involved inputs
+    std::vector<std::vector<int>> truePoints, falsePoints;
+    for (int mask = 0; mask < numCombinations; ++mask) {
+        std::vector<int> inputBinary(networkSize, 0);
+        for (int j = 0; j < numInputs; ++j)
+            inputBinary[nameToId.at(involvedVars[j])] = (mask >> j) & 1;
+        size_t i = 0;
+        bool output = BoolExprEvaluator::evalExpr(expr, i, inputBinary, nameToId);
+        (output ? truePoints : falsePoints).push_back(inputBinary);
+    }
+
+    threshold.clear();
+    if (falsePoints.empty() || truePoints.empty()) {
+        // Constant: 0 >= 0 always holds, 0 >= 1 never does
+        threshold.emplace_back(std::vector<int>(networkSize, 0), falsePoints.empty() ? 0 : 1);
+        return;
+    }
+
     try {
         GRBEnv env = GRBEnv(true);
         env.set(GRB_IntParam_OutputFlag, 0); // silent mode
+        env.set(GRB_DoubleParam_TimeLimit, ORDER_TIME_LIMIT);
         env.start();
-        GRBModel model = GRBModel(env);
-
-        // Create weight variables (bounded to ±infinity)
-        std::vector<GRBVar> weights, absWeights;
-        for (int i = 0; i < networkSize; ++i) {
-            GRBVar w = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER, "w_" + std::to_string(i));
-            GRBVar abs_w = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS, "abs_w_" + std::to_string(i));
-            weights.push_back(w);
-            absWeights.push_back(abs_w);
-
-            model.addConstr(abs_w >= w);
-            model.addConstr(abs_w >= -w);
-        }
 
-        // Create threshold variable
-        GRBVar thresholdVar = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER, "T");
-
-        // Add output constraints for all input combinations
-        for (int mask = 0; mask < numCombinations; ++mask) {
-            std::unordered_map<std::string, bool> inputValues;
-            std::vector<int> inputBinary(networkSize, 0);
-
-            for (int j = 0; j < numInputs; ++j) {
-                bool bit = (mask >> j) & 1;
-                inputValues[involvedVars[j]] = bit;
-                inputBinary[nameToId.at(involvedVars[j])] = bit;
+        int maxOrder = numInputs <= MULTI_ROW_MAX_INPUTS ? max_order : 1;
+        for (int order = 1; order <= maxOrder && order <= static_cast<int>(falsePoints.size()); ++order) {
+            GRBModel model = GRBModel(env);
+
+            // Create weight variables, only on the involved inputs
+            std::vector<std::vector<GRBVar>> weights(order, std::vector<GRBVar>(numInputs));
+            std::vector<GRBVar> thresholdVars(order);
+            GRBLinExpr obj = 0;
+            for (int r = 0; r < order; ++r) {
+                for (int j = 0; j < numInputs; ++j) {
+                    GRBVar w = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER,
+                        "w_" + std::to_string(r) + "_" + std::to_string(j));
+                    GRBVar abs_w = model.addVar(0.0, GRB_INFINITY, 0.0, GRB_CONTINUOUS,
+                        "abs_w_" + std::to_string(r) + "_" + std::to_string(j));
+                    model.addConstr(abs_w >= w);
+                    model.addConstr(abs_w >= -w);
+                    weights[r][j] = w;
+                    obj += abs_w;
+                }
+                thresholdVars[r] = model.addVar(-GRB_INFINITY, GRB_INFINITY, 0, GRB_INTEGER,
+                    "T_" + std::to_string(r));
+                // Rows are interchangeable; order them by threshold
+                if (r > 0) model.addConstr(thresholdVars[r - 1] <= thresholdVars[r]);
             }
-            size_t i = 0;
-            bool output = BoolExprEvaluator::evalExpr(expr, i, inputBinary, nameToId);
 
-            GRBLinExpr lhs = 0;
-            for (int k = 0; k < networkSize; ++k)
-                lhs += inputBinary[k] * weights[k];
+            auto rowSum = [&](int r, const std::vector<int>& point) {
+                GRBLinExpr lhs = 0;
+                for (int j = 0; j < numInputs; ++j)
+                    lhs += point[nameToId.at(involvedVars[j])] * weights[r][j];
+                return lhs;
+            };
+
+            // True points satisfy every row
+            for (const auto& point : truePoints)
+                for (int r = 0; r < order; ++r)
+                    model.addConstr(rowSum(r, point) >= thresholdVars[r]);
+
+            // False points violate at least one row. Indicators rather than big-M rows, so
+            // the weights need no bound that could cut off the smallest realization.
+            for (size_t m = 0; m < falsePoints.size(); ++m) {
+                if (order == 1) {
+                    model.addConstr(rowSum(0, falsePoints[m]) <= thresholdVars[0] - 1);
+                    continue;
+                }
+                GRBLinExpr violated = 0;
+                for (int r = 0; r < order; ++r) {
+                    GRBVar z = model.addVar(0, 1, 0, GRB_BINARY,
+                        "z_" + std::to_string(m) + "_" + std::to_string(r));
+                    model.addGenConstrIndicator(z, 1, rowSum(r, falsePoints[m]) - thresholdVars[r], GRB_LESS_EQUAL, -1);
+                    violated += z;
+                }
+                model.addConstr(violated >= 1);
+            }
 
-            if (output == 1)
-                model.addConstr(lhs >= thresholdVar);
-            else
-                model.addConstr(lhs <= thresholdVar - 1);
+            // Objective: minimize sum of absolute weights
+            model.setObjective(obj, GRB_MINIMIZE);
+            model.optimize();
+            // Out of time: a feasible set of rows is still exact, just not the smallest;
+            // without one, higher orders would only take longer
+            int status = model.get(GRB_IntAttr_Status);
+            if (status == GRB_TIME_LIMIT && model.get(GRB_IntAttr_SolCount) == 0) {
+                AILP_TRACE_COUNT("synthesis.time_limits", 1);
+                break;
+            }
+            if (status != GRB_OPTIMAL && status != GRB_TIME_LIMIT) continue;
+
+            // Store solved rows
+            for (int r = 0; r < order; ++r) {
+                std::vector<int> solvedWeights(networkSize, 0);
+                for (int j = 0; j < numInputs; ++j)
+                    solvedWeights[nameToId.at(involvedVars[j])] =
+                        static_cast<int>(round(weights[r][j].get(GRB_DoubleAttr_X)));
+                int solvedThreshold = static_cast<int>(round(thresholdVars[r].get(GRB_DoubleAttr_X)));
+                threshold.emplace_back(solvedWeights, solvedThreshold);
+            }
+            return;
         }
-
-        // Objective: minimize sum of absolute weights
-        GRBLinExpr obj = 0;
-        for (const auto& abs_w : absWeights)
-            obj += abs_w;
-
-        model.setObjective(obj, GRB_MINIMIZE);
-        model.optimize();
-
-        // Store solved weights and threshold
-        std::vector<int> solvedWeights(networkSize);
-        for (int i = 0; i < networkSize; ++i)
-            solvedWeights[i] = static_cast<int>(round(weights[i].get(GRB_DoubleAttr_X)));
-
-        int solvedThreshold = static_cast<int>(round(thresholdVar.get(GRB_DoubleAttr_X)));
-
-        threshold = std::make_pair(solvedWeights, solvedThreshold);
     } catch (GRBException& e) {
         std::cerr << "Gurobi Error: " << e.getMessage() << std::endl;
     } catch (...) {
         std::cerr << "Unknown error occurred while solving threshold function.\n";
     }
+
+    // One clause per false point: at least one input differs from it
+    AILP_TRACE_COUNT("synthesis.cnf_fallbacks", 1);
+    threshold.clear();
+    for (const auto& point : falsePoints) {
+        std::vector<int> clauseWeights(networkSize, 0);
+        int ones = 0;
+        for (int j = 0; j < numInputs; ++j) {
+            int id = nameToId.at(involvedVars[j]);
+            clauseWeights[id] = point[id] ? -1 : 1;
+            ones += point[id];
+        }
+        threshold.emplace_back(clauseWeights, 1 - ones);
+    }
 }
 
 std::vector<std::string> Node::getParents() const
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "OutOfCoreReachability.h"
+#include "ReachabilityKernel.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+class OutOfCoreError : public runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+class ScratchBudget {
+public:
+    explicit ScratchBudget(size_t limit) : limit(limit) {}
+
+    void reserve(size_t bytes) {
+        if (used + bytes > limit) throw OutOfCoreError("scratch budget exhausted");
+        used += bytes;
+    }
+    void release(size_t bytes) { used -= min(used, bytes); }
+
+private:
+    size_t limit;
+    size_t used = 0;
+};
+
+// Removes the per-check scratch directory however the search ends.
+class ScratchDirectory {
+public:
+    explicit ScratchDirectory(const string& root) {
+        static atomic<int> counter(0);
+        path = fs::path(root) / ("ailp_reach_" + to_string(getpid()) + "_" + to_string(counter++));
+        fs::create_directories(path);
+    }
+    ~ScratchDirectory() {
+        error_code ec;
+        fs::remove_all(path, ec);
+    }
+
+    fs::path path;
+};
+
+// Visited bitset split into fixed-size page files. Pages are created sparse on first
+// touch and memory-mapped on demand; the least recently used mapping is dropped
+// once max_mapped pages are mapped (the kernel writes dirty pages back).
+class PagedVisitedSet {
+public:
+    PagedVisitedSet(const fs::path& dir, int num_vars, size_t page_bytes, size_t max_mapped, ScratchBudget& budget)
+        : dir(dir), max_mapped(max(size_t(1), max_mapped)), budget(budget) {
+        uint64_t total_bytes = max<uint64_t>(8, (uint64_t(1) << num_vars) / 8);
+        this->page_bytes = min<uint64_t>(page_bytes, total_bytes);
+        page_bits = this->page_bytes * 8;
+        pages.resize((total_bytes + this->page_bytes - 1) / this->page_bytes);
+    }
+
+    ~PagedVisitedSet() {
+        for (auto& p : pages) {
+            if (p.data) munmap(p.data, page_bytes);
+        }
+    }
+
+    bool test_and_set(uint64_t state) {
+        uint8_t* data = page(state / page_bits);
+        uint64_t bit = state % page_bits;
+        uint8_t mask = uint8_t(1) << (bit & 7);
+        if (data[bit >> 3] & mask) return true;
+        data[bit >> 3] |= mask;
+        return false;
+    }
+
+private:
+    struct Page {
+        uint8_t* data = nullptr;
+        bool created = false;
+        uint64_t last_use = 0;
+    };
+
+    fs::path dir;
+    uint64_t page_bytes;
+    uint64_t page_bits;
+    size_t max_mapped;
+    ScratchBudget& budget;
+    vector<Page> pages;
+    vector<size_t> mapped;
+    uint64_t clock = 0;
+
+    uint8_t* page(size_t index) {
+        Page& p = pages[index];
+        p.last_use = ++clock;
+        if (p.data) return p.data;
+
+        if (mapped.size() >= max_mapped) {
+            auto lru = min_element(mapped.begin(), mapped.end(), [this](size_t a, size_t b) {
+                return pages[a].last_use < pages[b].last_use;
+            });
+            munmap(pages[*lru].data, page_bytes);
+            pages[*lru].data = nullptr;
+            mapped.erase(lru);
+        }
+
+        string file = (dir / ("visited_" + to_string(index) + ".bin")).string();
+        int fd = open(file.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) throw OutOfCoreError("cannot open " + file);
+        if (!p.created) {
+            budget.reserve(page_bytes);
+            if (ftruncate(fd, page_bytes) != 0) {
+                close(fd);
+                throw OutOfCoreError("cannot size " + file);
+            }
+            p.created = true;
+        }
+
+        void* data = mmap(nullptr, page_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) throw OutOfCoreError("cannot map " + file);
+
+        p.data = static_cast<uint8_t*>(data);
+        mapped.push_back(index);
+        return p.data;
+    }
+};
+
+struct FrontierRun {
+    string file;
+    size_t bytes;
+};
+
+// Collects one BFS level; every full buffer is sorted and written as a run of
+// LEB128-encoded deltas.
+class FrontierWriter {
+public:
+    FrontierWriter(const fs::path& dir, const string& prefix, size_t buffer_states, ScratchBudget& budget)
+        : dir(dir), prefix(prefix), buffer_states(max(size_t(1024), buffer_states)), budget(budget) {}
+
+    void add(uint64_t state) {
+        buffer.push_back(state);
+        if (buffer.size() >= buffer_states) flush();
+    }
+
+    vector<FrontierRun> finish() {
+        flush();
+        return move(runs);
+    }
+
+private:
+    fs::path dir;
+    string prefix;
+    size_t buffer_states;
+    ScratchBudget& budget;
+    vector<uint64_t> buffer;
+    vector<FrontierRun> runs;
+
+    void flush() {
+        if (buffer.empty()) return;
+        sort(buffer.begin(), buffer.end());
+        buffer.erase(unique(buffer.begin(), buffer.end()), buffer.end());
+
+        string file = (dir / (prefix + "_" + to_string(runs.size()) + ".run")).string();
+        unique_ptr<FILE, int (*)(FILE*)> out(fopen(file.c_str(), "wb"), fclose);
+        if (!out) throw OutOfCoreError("cannot write " + file);
+
+        size_t bytes = 0;
+        uint64_t previous = 0;
+        for (uint64_t s : buffer) {
+            uint64_t delta = s - previous;
+            previous = s;
+            do {
+                uint8_t byte = delta & 0x7f;
+                delta >>= 7;
+                if (delta) byte |= 0x80;
+                fputc(byte, out.get());
+                bytes++;
+            } while (delta);
+        }
+        if (ferror(out.get())) throw OutOfCoreError("write failed for " + file);
+
+        budget.reserve(bytes);
+        runs.push_back({file, bytes});
+        buffer.clear();
+    }
+};
+
+class RunReader {
+public:
+    explicit RunReader(const string& file) : in(fopen(file.c_str(), "rb"), fclose) {
+        if (!in) throw OutOfCoreError("cannot read " + file);
+        setvbuf(in.get(), nullptr, _IOFBF, 1 << 20);
+    }
+
+    bool next(uint64_t& state) {
+        uint64_t delta = 0;
+        int shift = 0;
+        int c;
+        while ((c = fgetc(in.get())) != EOF) {
+            delta |= uint64_t(c & 0x7f) << shift;
+            shift += 7;
+            if (!(c & 0x80)) {
+                current += delta;
+                state = current;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    unique_ptr<FILE, int (*)(FILE*)> in;
+    uint64_t current = 0;
+};
+
+// K-way merge of the sorted runs of one level.
+class FrontierMerger {
+public:
+    explicit FrontierMerger(const vector<FrontierRun>& runs) {
+        for (const auto& r : runs) {
+            readers.push_back(make_unique<RunReader>(r.file));
+            uint64_t s;
+            if (readers.back()->next(s)) heap.push({s, readers.size() - 1});
+        }
+    }
+
+    bool next(uint64_t& state) {
+        if (heap.empty()) return false;
+        auto [s, i] = heap.top();
+        heap.pop();
+        uint64_t following;
+        if (readers[i]->next(following)) heap.push({following, i});
+        state = s;
+        return true;
+    }
+
+private:
+    using Entry = pair<uint64_t, size_t>;
+    vector<unique_ptr<RunReader>> readers;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> heap;
+};
+
+void remove_runs(const vector<FrontierRun>& runs, ScratchBudget& budget) {
+    for (const auto& r : runs) {
+        error_code ec;
+        fs::remove(r.file, ec);
+        budget.release(r.bytes);
+    }
+}
+
+}
+
+long long count_unreachable_states_out_of_core(const ExplorationSystem& system,
+                                               const vector<vector<int>>& initial_cubes,
+                                               const ReachabilityOptions& options) {
+    const int n = system.num_vars;
+    if (options.scratch_directory.empty() || n > MAX_OUT_OF_CORE_VARS) return -1;
+
+    const uint64_t total = uint64_t(1) << n;
+    // A quarter of the memory budget buffers the next frontier, the rest holds mapped pages.
+    const size_t buffer_states = options.memory_budget_bytes / 4 / sizeof(uint64_t);
+    const size_t max_mapped = options.memory_budget_bytes * 3 / 4 / max<size_t>(1, options.visited_page_bytes);
+
+    try {
+        ScratchDirectory scratch(options.scratch_directory);
+        ScratchBudget budget(options.scratch_budget_bytes);
+        PagedVisitedSet visited(scratch.path, n, options.visited_page_bytes, max_mapped, budget);
+        FrontierBlockKernel kernel(system);
+
+        uint64_t reached = 0;
+        int level = 0;
+
+        FrontierWriter initial(scratch.path, "level_0", buffer_states, budget);
+        for (const auto& c : initial_cubes) {
+            uint64_t base = 0;
+            vector<int> free_positions;
+            for (size_t i = 0; i < c.size(); ++i) {
+                if (c[i] == 1) base |= uint64_t(1) << i;
+                else if (c[i] == -1) free_positions.push_back(i);
+            }
+            for (uint64_t m = 0; m < (uint64_t(1) << free_positions.size()); ++m) {
+                uint64_t s = base;
+                for (size_t b = 0; b < free_positions.size(); ++b) {
+                    if ((m >> b) & 1) s |= uint64_t(1) << free_positions[b];
+                }
+                if (visited.test_and_set(s)) continue;
+                reached++;
+                initial.add(s);
+            }
+        }
+        vector<FrontierRun> runs = initial.finish();
+
+        vector<uint64_t> block;
+        uint64_t masks[FrontierBlockKernel::BLOCK_SIZE];
+        while (!runs.empty() && reached < total) {
+            FrontierWriter next(scratch.path, "level_" + to_string(++level), buffer_states, budget);
+
+            auto expand_block = [&]() {
+                kernel.evaluate(block.data(), block.size(), masks);
+                for (size_t i = 0; i < block.size(); ++i) {
+                    for (uint64_t bits = masks[i]; bits; bits &= bits - 1) {
+                        uint64_t y = block[i] ^ (uint64_t(1) << __builtin_ctzll(bits));
+                        if (visited.test_and_set(y)) continue;
+                        reached++;
+                        next.add(y);
+                    }
+                }
+                block.clear();
+            };
+
+            {
+                FrontierMerger merger(runs);
+                uint64_t s;
+                while (merger.next(s)) {
+                    block.push_back(s);
+                    if (block.size() == FrontierBlockKernel::BLOCK_SIZE) expand_block();
+                }
+                if (!block.empty()) expand_block();
+            }
+
+            remove_runs(runs, budget);
+            runs = next.finish();
+        }
+
+        return static_cast<long long>(total - reached);
+    } catch (const exception& e) {
+        cout << "out-of-core reachability: " << e.what() << endl;
+        return -1;
+    }
+}
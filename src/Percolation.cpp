@@ -0,0 +1,171 @@
+#include <iostream>
+
+#include "Percolation.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+// State nodes reading each input (state nodes first, then externals)
+vector<vector<int>> get_successors(const BooleanNetwork& network) {
+    const int state_size = network.state_size;
+    const int input_size = state_size + network.external_size;
+    vector<vector<int>> successors(input_size);
+    for (const auto& [k, functions] : network.threshold_functions) {
+        if (k >= state_size) continue;
+        vector<bool> reads(input_size, false);
+        for (const auto& [weights, threshold] : functions) {
+            for (size_t i = 0; i < weights.size() && static_cast<int>(i) < input_size; ++i) {
+                if (weights[i] != 0) reads[i] = true;
+            }
+        }
+        for (int i = 0; i < input_size; ++i) {
+            if (reads[i]) successors[i].push_back(k);
+        }
+    }
+    return successors;
+}
+
+// Forces what the queued nodes' rows decide, following successors of every new value
+void propagate(const BooleanNetwork& network, const vector<vector<int>>& successors,
+               vector<int>& value, vector<int> queue) {
+    const int state_size = network.state_size;
+    const int input_size = value.size();
+    vector<bool> queued(state_size, false);
+    for (int k : queue) queued[k] = true;
+
+    while (!queue.empty()) {
+        int k = queue.back();
+        queue.pop_back();
+        queued[k] = false;
+        if (value[k] != -1) continue;
+
+        bool always_on = true, always_off = false;
+        for (const auto& [weights, threshold] : network.threshold_functions.at(k)) {
+            long long low = 0, high = 0;
+            for (size_t i = 0; i < weights.size() && static_cast<int>(i) < input_size; ++i) {
+                int w = weights[i];
+                if (w == 0) continue;
+                if (value[i] != -1) {
+                    low += w * value[i];
+                    high += w * value[i];
+                } else if (w > 0) {
+                    high += w;
+                } else {
+                    low += w;
+                }
+            }
+            always_on &= low >= threshold;
+            always_off |= high < threshold;
+        }
+
+        if (always_off) {
+            value[k] = 0;
+        } else if (always_on) {
+            value[k] = 1;
+        } else {
+            continue;
+        }
+
+        for (int s : successors[k]) {
+            if (value[s] == -1 && !queued[s]) {
+                queue.push_back(s);
+                queued[s] = true;
+            }
+        }
+    }
+}
+
+PercolationResult to_percolation_result(const vector<int>& value, int state_size) {
+    PercolationResult result;
+    for (int i = 0; i < static_cast<int>(value.size()); ++i) {
+        if (value[i] == -1) {
+            if (i < state_size) result.free_states.push_back(i);
+            continue;
+        }
+        result.known_inputs[i] = value[i];
+        if (i < state_size) result.forced_states[i] = value[i];
+    }
+    return result;
+}
+
+}
+
+PercolationResult percolate_constants(const BooleanNetwork& network,
+                                      const map<int, int>& fixed_externals) {
+    AILP_TRACE_SCOPE(scope, "percolation");
+    const int state_size = network.state_size;
+    const int input_size = state_size + network.external_size;
+
+    vector<int> value(input_size, -1);
+    for (const auto& [ext, v] : fixed_externals) {
+        if (ext >= 0 && ext < network.external_size) value[state_size + ext] = v;
+    }
+
+    vector<int> queue;
+    for (int k = 0; k < state_size; ++k) {
+        if (network.threshold_functions.count(k)) queue.push_back(k);
+    }
+    propagate(network, get_successors(network), value, queue);
+
+    PercolationResult result = to_percolation_result(value, state_size);
+    cout << "Percolation: forced " << result.forced_states.size() << " / " << state_size
+         << " state nodes" << endl;
+    return result;
+}
+
+PercolationResult percolate_perturbation(const BooleanNetwork& network, const PercolationResult& base,
+                                         const map<int, int>& fixed_states) {
+    AILP_TRACE_SCOPE(scope, "percolation.perturbation");
+    const int state_size = network.state_size;
+    const int input_size = state_size + network.external_size;
+    vector<vector<int>> successors = get_successors(network);
+
+    // Values outside the downstream cone of the perturbed nodes cannot change
+    vector<bool> in_cone(state_size, false);
+    vector<int> cone;
+    for (const auto& [k, v] : fixed_states) {
+        if (k < 0 || k >= state_size || in_cone[k]) continue;
+        in_cone[k] = true;
+        cone.push_back(k);
+    }
+    for (size_t c = 0; c < cone.size(); ++c) {
+        for (int s : successors[cone[c]]) {
+            if (!in_cone[s]) {
+                in_cone[s] = true;
+                cone.push_back(s);
+            }
+        }
+    }
+
+    vector<int> value(input_size, -1);
+    for (const auto& [i, v] : base.known_inputs) {
+        if (i >= state_size || !in_cone[i]) value[i] = v;
+    }
+    vector<int> queue;
+    for (const auto& [k, v] : fixed_states) {
+        if (k >= 0 && k < state_size) value[k] = v;
+    }
+    for (int k : cone) {
+        if (value[k] == -1 && network.threshold_functions.count(k)) queue.push_back(k);
+    }
+    AILP_TRACE_ARG(scope, "cone", static_cast<long long>(cone.size()));
+    propagate(network, successors, value, queue);
+
+    return to_percolation_result(value, state_size);
+}
+
+ThresholdFunctions reduce_threshold_functions(const ThresholdFunctions& functions,
+                                              const map<int, int>& known_inputs) {
+    ThresholdFunctions reduced;
+    for (auto [weights, threshold] : functions) {
+        for (const auto& [i, v] : known_inputs) {
+            if (i >= static_cast<int>(weights.size())) break;
+            threshold -= weights[i] * v;
+            weights[i] = 0;
+        }
+        reduced.emplace_back(weights, threshold);
+    }
+    return reduced;
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "PerturbationScreen.h"
+#include "ILPModelBuilder.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+PercolationResult get_perturbed_percolation(BooleanNetwork& network, const PercolationResult& wild_type,
+                                            const Perturbation& perturbation) {
+    if (enumeration_options.percolate) return percolate_perturbation(network, wild_type, perturbation);
+
+    PercolationResult percolation = wild_type;
+    for (const auto& [k, v] : perturbation) {
+        percolation.forced_states[k] = v;
+        percolation.known_inputs[k] = v;
+    }
+    percolation.free_states.erase(remove_if(percolation.free_states.begin(), percolation.free_states.end(),
+                                            [&perturbation](int k) { return perturbation.count(k) > 0; }),
+                                  percolation.free_states.end());
+    return percolation;
+}
+
+vector<map<int, int>> enumerate_on_copy(ILPModel& ilp_model, const Perturbation& perturbation,
+                                        const PercolationResult& percolation) {
+    clamp_nodes(ilp_model, perturbation);
+
+    // Nodes the perturbation forces downstream only get their bounds tightened; their
+    // functions still agree with the forced value.
+    for (size_t i = 0; i < ilp_model.node_ids.size(); ++i) {
+        int k = ilp_model.node_ids[i];
+        auto forced = percolation.forced_states.find(k);
+        if (forced == percolation.forced_states.end() || perturbation.count(k)) continue;
+        ilp_model.states_vars[i].set(GRB_DoubleAttr_LB, forced->second);
+        ilp_model.states_vars[i].set(GRB_DoubleAttr_UB, forced->second);
+        ilp_model.fixed_vars[i].set(GRB_DoubleAttr_LB, 1);
+    }
+
+    // The perturbed nodes are always fixed, so this includes the percolated space
+    vector<map<int, int>> trap_spaces = enumerate_by_size(ilp_model, ilp_model.node_ids.size());
+    if (trap_spaces.empty()) trap_spaces.push_back(percolation.forced_states);
+    return trap_spaces;
+}
+
+set<map<int, int>> project_out(const vector<map<int, int>>& trap_spaces, const Perturbation& perturbation) {
+    set<map<int, int>> projected;
+    for (auto space : trap_spaces) {
+        for (const auto& [k, v] : perturbation) space.erase(k);
+        projected.insert(space);
+    }
+    return projected;
+}
+
+void compare_with_wild_type(PerturbationOutcome& outcome, const vector<map<int, int>>& wild_type) {
+    set<map<int, int>> before = project_out(wild_type, outcome.perturbation);
+    set<map<int, int>> after = project_out(outcome.trap_spaces, outcome.perturbation);
+    for (const auto& space : after) {
+        if (!before.count(space)) outcome.appeared.push_back(space);
+    }
+    for (const auto& space : before) {
+        if (!after.count(space)) outcome.vanished.push_back(space);
+    }
+}
+
+string format_space(const BooleanNetwork& network, const map<int, int>& space) {
+    if (space.empty()) return "-";
+    string out;
+    for (const auto& [id, v] : space) {
+        if (!out.empty()) out += ",";
+        out += network.index_to_name[id] + "=" + to_string(v);
+    }
+    return out;
+}
+
+string format_spaces(const BooleanNetwork& network, const vector<map<int, int>>& spaces) {
+    if (spaces.empty()) return "-";
+    string out;
+    for (const auto& space : spaces) {
+        if (!out.empty()) out += ";";
+        out += format_space(network, space);
+    }
+    return out;
+}
+
+}
+
+vector<Perturbation> single_perturbations(const BooleanNetwork& network, bool knockouts, bool overexpressions) {
+    vector<Perturbation> perturbations;
+    for (int k = 0; k < network.state_size; ++k) {
+        if (knockouts) perturbations.push_back({{k, 0}});
+        if (overexpressions) perturbations.push_back({{k, 1}});
+    }
+    return perturbations;
+}
+
+vector<Perturbation> double_perturbations(const BooleanNetwork& network, bool knockouts, bool overexpressions) {
+    vector<Perturbation> singles = single_perturbations(network, knockouts, overexpressions);
+    vector<Perturbation> perturbations;
+    for (size_t a = 0; a < singles.size(); ++a) {
+        for (size_t b = a + 1; b < singles.size(); ++b) {
+            if (singles[a].begin()->first == singles[b].begin()->first) continue;
+            Perturbation both = singles[a];
+            both.insert(*singles[b].begin());
+            perturbations.push_back(both);
+        }
+    }
+    return perturbations;
+}
+
+PerturbationScreenResult screen_perturbations(BooleanNetwork& network, const vector<Perturbation>& perturbations) {
+    AILP_TRACE_SCOPE(scope, "screen_perturbations");
+    AILP_TRACE_ARG(scope, "perturbations", static_cast<long long>(perturbations.size()));
+    PerturbationScreenResult result;
+    PercolationResult wild_type = get_percolation(network, enumeration_options.fixed_externals);
+    result.wild_type = find_trap_spaces(network, wild_type);
+
+    // One wild-type model, copied for every perturbation of nodes it still has variables for
+    auto reusable = [&wild_type](const Perturbation& perturbation) {
+        return all_of(perturbation.begin(), perturbation.end(), [&wild_type](const auto& entry) {
+            return binary_search(wild_type.free_states.begin(), wild_type.free_states.end(), entry.first);
+        });
+    };
+    unique_ptr<ILPModel> base_model;
+    if (any_of(perturbations.begin(), perturbations.end(), reusable)) {
+        vector<int> branch_nodes;
+        if (enumeration_options.use_fvs) branch_nodes = get_feedback_vertex_set(network, wild_type.free_states);
+        base_model = make_unique<ILPModel>(
+            build_ilp_model(network, wild_type.free_states.size(), wild_type, branch_nodes));
+    }
+
+    result.outcomes.resize(perturbations.size());
+    mutex base_lock;
+    atomic<size_t> next_perturbation(0);
+    vector<exception_ptr> errors(perturbations.size());
+    auto worker = [&]() {
+        unique_ptr<GRBEnv> env;
+        unique_ptr<ILPModel> thread_base;
+        for (size_t p = next_perturbation++; p < perturbations.size(); p = next_perturbation++) {
+            try {
+                AILP_TRACE_SCOPE(perturbation_scope, "screen.perturbation");
+                PerturbationOutcome& outcome = result.outcomes[p];
+                outcome.perturbation = perturbations[p];
+                PercolationResult percolation = get_perturbed_percolation(network, wild_type, outcome.perturbation);
+
+                if (base_model && reusable(outcome.perturbation)) {
+                    if (!thread_base) {
+                        env = make_unique<GRBEnv>();
+                        env->set(GRB_IntParam_OutputFlag, 0);
+                        lock_guard<mutex> guard(base_lock);
+                        thread_base = make_unique<ILPModel>(copy_ilp_model(*base_model, *env));
+                    }
+                    ILPModel ilp_model = copy_ilp_model(*thread_base, *env);
+                    outcome.trap_spaces = enumerate_on_copy(ilp_model, outcome.perturbation, percolation);
+                    outcome.reused_model = true;
+                } else {
+                    outcome.trap_spaces = find_trap_spaces(network, percolation);
+                }
+                compare_with_wild_type(outcome, result.wild_type);
+            } catch (...) {
+                errors[p] = current_exception();
+            }
+        }
+    };
+
+    int threads = enumeration_options.threads > 0 ? enumeration_options.threads
+                                                  : static_cast<int>(thread::hardware_concurrency());
+    threads = max(1, min<int>(threads, perturbations.size()));
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    for (const auto& e : errors) {
+        if (e) rethrow_exception(e);
+    }
+
+    int changed = count_if(result.outcomes.begin(), result.outcomes.end(), [](const PerturbationOutcome& outcome) {
+        return !outcome.appeared.empty() || !outcome.vanished.empty();
+    });
+    cout << "Screen: " << perturbations.size() << " perturbations, " << changed
+         << " change the trap spaces" << endl;
+    return result;
+}
+
+bool write_screen_report(const BooleanNetwork& network, const PerturbationScreenResult& result, const string& path) {
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "perturbation\ttrap_spaces\tappeared\tvanished\n";
+    out << "-\t" << result.wild_type.size() << "\t-\t-\n";
+    for (const auto& outcome : result.outcomes) {
+        out << format_space(network, outcome.perturbation) << "\t" << outcome.trap_spaces.size() << "\t"
+            << format_spaces(network, outcome.appeared) << "\t" << format_spaces(network, outcome.vanished) << "\n";
+    }
+    return static_cast<bool>(out);
+}
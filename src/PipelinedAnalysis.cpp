@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "PipelinedAnalysis.h"
+#include "BoundedQueue.h"
+#include "ILPModelBuilder.h"
+#include "IncludingSolutions.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+// Thrown through the enumeration when a later stage has failed and closed its queue
+struct PipelineClosed {};
+
+}
+
+SolutionObjects find_and_prune_pipelined(BooleanNetwork& network, const ExternalAssigner& assign_externals,
+                                         bool is_verify_sub_solutions) {
+    AILP_TRACE_SCOPE(scope, "find_and_prune_pipelined");
+    BoundedQueue<map<int, int>> spaces(pipeline_options.queue_capacity);
+    BoundedQueue<InclusionTask> tasks(pipeline_options.queue_capacity);
+
+    // Written only by the hierarchy stage until every stage has finished
+    SolutionObjects solutions;
+    vector<pair<InclusionTask, InclusionVerdict>> verdicts;
+    mutex verdict_lock;
+    InclusionCache done;
+
+    mutex error_lock;
+    exception_ptr error;
+    auto fail = [&](exception_ptr e) {
+        {
+            lock_guard<mutex> guard(error_lock);
+            if (!error) error = e;
+        }
+        spaces.close();
+        tasks.close();
+    };
+
+    auto enumerate = [&]() {
+        try {
+            AILP_TRACE_SCOPE(stage_scope, "pipeline.enumeration");
+            PercolationResult percolation = get_percolation(network, enumeration_options.fixed_externals);
+            find_trap_spaces(network, percolation, [&spaces](const map<int, int>& space) {
+                if (!spaces.push(space)) throw PipelineClosed();
+            });
+        } catch (const PipelineClosed&) {
+        } catch (...) {
+            fail(current_exception());
+        }
+        spaces.close();
+    };
+
+    atomic<int> queued_checks(0);
+    int trap_spaces = 0;
+    auto build_hierarchy = [&]() {
+        try {
+            AILP_TRACE_SCOPE(stage_scope, "pipeline.hierarchy");
+            size_t previous_size = SIZE_MAX;
+            while (auto space = spaces.pop()) {
+                if (space->size() > previous_size) {
+                    throw logic_error("find_and_prune_pipelined: trap spaces must arrive largest first");
+                }
+                previous_size = space->size();
+                ++trap_spaces;
+
+                SolutionObjects assigned = assign_externals(*space);
+                for (const auto& [id, solution] : assigned.solutions) {
+                    int solution_id = solutions.add_solution(solution.stable_nodes);
+                    int external_id = solutions.add_externals_assignments(
+                        assigned.external_assignments[assigned.solution_to_externals[id]]);
+                    solutions.update_external_to_solution(solution_id, external_id);
+
+                    add_to_solutions_hierarchy_tree(network, solutions, solution_id);
+                    auto edges = solutions.all_included_solutions.find(solution_id);
+                    if (edges == solutions.all_included_solutions.end() || edges->second.empty()) continue;
+                    ++queued_checks;
+                    if (!tasks.push(make_inclusion_task(network, solutions, solution_id, is_verify_sub_solutions))) {
+                        return;
+                    }
+                }
+            }
+        } catch (...) {
+            fail(current_exception());
+        }
+        tasks.close();
+    };
+
+    auto check = [&]() {
+        try {
+            while (auto task = tasks.pop()) {
+                AILP_TRACE_SCOPE(check_scope, "pipeline.check");
+                // Budget share: this check and the ones waiting behind it
+                int checks_left = static_cast<int>(tasks.size()) + 1;
+                InclusionVerdict verdict = check_inclusion_task(network, *task, done, is_verify_sub_solutions,
+                                                                checks_left);
+                lock_guard<mutex> guard(verdict_lock);
+                verdicts.emplace_back(move(*task), move(verdict));
+            }
+        } catch (...) {
+            fail(current_exception());
+        }
+    };
+
+    int threads = enumeration_options.threads > 0 ? enumeration_options.threads
+                                                  : static_cast<int>(thread::hardware_concurrency());
+    int checkers = max(1, threads - 2);
+    vector<thread> pool;
+    pool.emplace_back(enumerate);
+    pool.emplace_back(build_hierarchy);
+    for (int t = 1; t < checkers; ++t) pool.emplace_back(check);
+    check();
+    for (auto& th : pool) th.join();
+
+    if (error) rethrow_exception(error);
+
+    // Verdicts in solution order, so split-off solutions get the ids the sequential pass gives them
+    sort(verdicts.begin(), verdicts.end(), [](const auto& a, const auto& b) {
+        return a.first.solution.solution_id < b.first.solution.solution_id;
+    });
+    int original_solution_size = solutions.solutions.size();
+    cout << "Pipeline: " << trap_spaces << " trap spaces, " << original_solution_size << " solutions, "
+         << queued_checks << " inclusion checks" << endl;
+    for (const auto& [task, verdict] : verdicts) {
+        apply_inclusion_verdict(solutions, task, verdict);
+    }
+    drop_included_solutions(solutions, original_solution_size);
+    return solutions;
+}
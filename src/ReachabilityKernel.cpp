@@ -0,0 +1,488 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AILP_AVX2_KERNEL 1
+#endif
+
+#include "ReachabilityKernel.h"
+
+using namespace std;
+
+namespace {
+
+class VisitedSet {
+public:
+    explicit VisitedSet(int num_vars) : bits(((uint64_t(1) << num_vars) + 63) / 64, 0) {}
+
+    bool test_and_set(uint64_t state) {
+        uint64_t mask = uint64_t(1) << (state & 63);
+        uint64_t& word = bits[state >> 6];
+        if (word & mask) return true;
+        word |= mask;
+        return false;
+    }
+
+    bool test(uint64_t state) const {
+        return (bits[state >> 6] >> (state & 63)) & 1;
+    }
+
+private:
+    vector<uint64_t> bits;
+};
+
+class AtomicVisitedSet {
+public:
+    explicit AtomicVisitedSet(int num_vars)
+        : words(((uint64_t(1) << num_vars) + 63) / 64), bits(new atomic<uint64_t>[words]) {
+        for (size_t i = 0; i < words; ++i) bits[i].store(0, memory_order_relaxed);
+    }
+
+    bool test_and_set(uint64_t state) {
+        uint64_t mask = uint64_t(1) << (state & 63);
+        atomic<uint64_t>& word = bits[state >> 6];
+        // Most neighbours are already visited late in the search; skip the RMW for those.
+        if (word.load(memory_order_relaxed) & mask) return true;
+        return word.fetch_or(mask, memory_order_relaxed) & mask;
+    }
+
+private:
+    size_t words;
+    unique_ptr<atomic<uint64_t>[]> bits;
+};
+
+// Per-row inputs of one batched evaluation: flip_mask[r] is all ones when the row's own
+// node is set in the state (its weight leaves the sum in the neighbour), zero otherwise.
+// row_ok[r] receives whether the row holds in that neighbour.
+void rows_scalar(uint64_t state, int padded_rows, const int32_t* columns,
+                 const int32_t* diagonal, const int32_t* thresholds, const int32_t* flip_mask,
+                 int32_t* sums, uint8_t* row_ok) {
+    fill(sums, sums + padded_rows, 0);
+    for (uint64_t bits = state; bits; bits &= bits - 1) {
+        const int32_t* column = columns + static_cast<size_t>(__builtin_ctzll(bits)) * padded_rows;
+        for (int r = 0; r < padded_rows; ++r) sums[r] += column[r];
+    }
+    for (int r = 0; r < padded_rows; ++r) {
+        int32_t delta = (diagonal[r] ^ flip_mask[r]) - flip_mask[r];
+        row_ok[r] = sums[r] + delta >= thresholds[r];
+    }
+}
+
+#ifdef AILP_AVX2_KERNEL
+__attribute__((target("avx2")))
+void rows_avx2_16(uint64_t state, int padded_rows, const int16_t* columns, const int16_t* diagonal,
+                  const int16_t* thresholds, const int16_t* flip_mask, uint8_t* row_ok) {
+    alignas(32) int16_t below[16];
+    for (int c = 0; c < padded_rows; c += 16) {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint64_t bits = state; bits; bits &= bits - 1) {
+            const int16_t* column = columns + static_cast<size_t>(__builtin_ctzll(bits)) * padded_rows + c;
+            sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column)));
+        }
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flip_mask + c));
+        __m256i diag = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(diagonal + c));
+        __m256i delta = _mm256_sub_epi16(_mm256_xor_si256(diag, mask), mask);
+        __m256i pred = _mm256_add_epi16(sum, delta);
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(thresholds + c));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(below), _mm256_cmpgt_epi16(t, pred));
+        for (int k = 0; k < 16; ++k) row_ok[c + k] = below[k] == 0;
+    }
+}
+
+__attribute__((target("avx2")))
+void rows_avx2_32(uint64_t state, int padded_rows, const int32_t* columns, const int32_t* diagonal,
+                  const int32_t* thresholds, const int32_t* flip_mask, uint8_t* row_ok) {
+    alignas(32) int32_t below[8];
+    for (int c = 0; c < padded_rows; c += 8) {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint64_t bits = state; bits; bits &= bits - 1) {
+            const int32_t* column = columns + static_cast<size_t>(__builtin_ctzll(bits)) * padded_rows + c;
+            sum = _mm256_add_epi32(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column)));
+        }
+        __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flip_mask + c));
+        __m256i diag = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(diagonal + c));
+        __m256i delta = _mm256_sub_epi32(_mm256_xor_si256(diag, mask), mask);
+        __m256i pred = _mm256_add_epi32(sum, delta);
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(thresholds + c));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(below), _mm256_cmpgt_epi32(t, pred));
+        for (int k = 0; k < 8; ++k) row_ok[c + k] = below[k] == 0;
+    }
+}
+#endif
+
+void compute_row_sums(const ExplorationSystem& system, uint64_t state, int* sums) {
+    for (int r = 0; r < system.num_rows(); ++r) {
+        const int* w = system.row(r);
+        int sum = 0;
+        for (int j = 0; j < system.num_vars; ++j) {
+            if ((state >> j) & 1) sum += w[j];
+        }
+        sums[r] = sum;
+    }
+}
+
+}
+
+vector<uint64_t> expand_cubes(const vector<vector<int>>& initial_cubes) {
+    vector<uint64_t> states;
+    for (const auto& c : initial_cubes) {
+        uint64_t base = 0;
+        vector<int> free_positions;
+        for (size_t i = 0; i < c.size(); ++i) {
+            if (c[i] == 1) base |= uint64_t(1) << i;
+            else if (c[i] == -1) free_positions.push_back(i);
+        }
+        for (uint64_t m = 0; m < (uint64_t(1) << free_positions.size()); ++m) {
+            uint64_t s = base;
+            for (size_t b = 0; b < free_positions.size(); ++b) {
+                if ((m >> b) & 1) s |= uint64_t(1) << free_positions[b];
+            }
+            states.push_back(s);
+        }
+    }
+    return states;
+}
+
+long long count_unreachable_states(const ExplorationSystem& system,
+                                   const vector<vector<int>>& initial_cubes,
+                                   uint64_t max_states,
+                                   const SearchCancelled& cancelled) {
+    const int n = system.num_vars;
+    const int rows = system.num_rows();
+    const uint64_t total = uint64_t(1) << n;
+
+    VisitedSet visited(n);
+    uint64_t reached = 0;
+    uint64_t expanded = 0;
+    const bool unate = static_cast<int>(system.self_unateness.size()) == n;
+
+    // Level-synchronous so only two levels of row sums are alive at a time.
+    vector<uint64_t> frontier, next_frontier;
+    vector<int> frontier_sums, next_sums;
+
+    for (uint64_t s : expand_cubes(initial_cubes)) {
+        if (visited.test_and_set(s)) continue;
+        reached++;
+        frontier.push_back(s);
+        frontier_sums.resize(frontier_sums.size() + rows);
+        compute_row_sums(system, s, frontier_sums.data() + frontier_sums.size() - rows);
+    }
+
+    while (!frontier.empty() && reached < total) {
+        if (cancelled && cancelled()) return -1;
+        next_frontier.clear();
+        next_sums.clear();
+
+        for (size_t f = 0; f < frontier.size(); ++f) {
+            if (max_states && ++expanded > max_states) return -1;
+
+            const uint64_t x = frontier[f];
+            const int* sx = frontier_sums.data() + f * rows;
+
+            for (int j = 0; j < n; ++j) {
+                const uint64_t y = x ^ (uint64_t(1) << j);
+
+                // y -> x is a transition iff f_j(y) == x_j. Only node j's rows are needed,
+                // and each differs from x's by the weight of j itself. The test runs before
+                // the visited lookup, which is the random memory access here.
+                const int x_j = (x >> j) & 1;
+                const int sign = x_j ? -1 : 1;
+
+                // f_j(x) settles most flips when j is unate in itself: y only differs in
+                // j, so f_j(y) == f_j(x) without self-dependence, f_j(y) can only move
+                // away from x_j when positive and only towards it when negative.
+                const int self = unate ? system.self_unateness[j] : 0;
+                int valid = -1;
+                if (self != 0) {
+                    int f_x = 1;
+                    for (int r = system.row_begin[j]; r < system.row_begin[j + 1]; ++r) {
+                        if (sx[r] < system.thresholds[r]) {
+                            f_x = 0;
+                            break;
+                        }
+                    }
+                    if ((self == 2 || self == 1) && f_x != x_j) valid = 0;
+                    else if ((self == 2 || self == -1) && f_x == x_j) valid = 1;
+                }
+                if (valid == -1) {
+                    int f_j = 1;
+                    for (int r = system.row_begin[j]; r < system.row_begin[j + 1]; ++r) {
+                        if (sx[r] + sign * system.row(r)[j] < system.thresholds[r]) {
+                            f_j = 0;
+                            break;
+                        }
+                    }
+                    valid = f_j == x_j;
+                }
+                if (!valid || visited.test_and_set(y)) continue;
+
+                reached++;
+                next_frontier.push_back(y);
+
+                size_t offset = next_sums.size();
+                next_sums.resize(offset + rows);
+                for (int r = 0; r < rows; ++r) {
+                    next_sums[offset + r] = sx[r] + sign * system.row(r)[j];
+                }
+            }
+        }
+
+        swap(frontier, next_frontier);
+        swap(frontier_sums, next_sums);
+    }
+
+    return static_cast<long long>(total - reached);
+}
+
+long long count_unreachable_states_full_recompute(const ExplorationSystem& system,
+                                                  const vector<vector<int>>& initial_cubes,
+                                                  uint64_t max_states) {
+    const int n = system.num_vars;
+    const uint64_t total = uint64_t(1) << n;
+
+    VisitedSet visited(n);
+    uint64_t reached = 0;
+    uint64_t expanded = 0;
+    queue<uint64_t> exploration_queue;
+    vector<int> sums(system.num_rows());
+
+    for (uint64_t s : expand_cubes(initial_cubes)) {
+        if (visited.test_and_set(s)) continue;
+        reached++;
+        exploration_queue.push(s);
+    }
+
+    while (!exploration_queue.empty() && reached < total) {
+        if (max_states && ++expanded > max_states) return -1;
+
+        uint64_t x = exploration_queue.front();
+        exploration_queue.pop();
+
+        for (int j = 0; j < n; ++j) {
+            uint64_t y = x ^ (uint64_t(1) << j);
+            if (visited.test(y)) continue;
+
+            compute_row_sums(system, y, sums.data());
+            int f_j = 1;
+            for (int r = system.row_begin[j]; r < system.row_begin[j + 1]; ++r) {
+                if (sums[r] < system.thresholds[r]) f_j = 0;
+            }
+            if (f_j != static_cast<int>((x >> j) & 1)) continue;
+
+            visited.test_and_set(y);
+            reached++;
+            exploration_queue.push(y);
+        }
+    }
+
+    return static_cast<long long>(total - reached);
+}
+
+FrontierBlockKernel::FrontierBlockKernel(const ExplorationSystem& system)
+    : num_vars(system.num_vars), rows(system.num_rows()), narrow(true), avx2(false),
+      row_begin(system.row_begin), row_node(system.num_rows()) {
+    for (int v = 0; v < num_vars; ++v) {
+        for (int r = row_begin[v]; r < row_begin[v + 1]; ++r) row_node[r] = v;
+    }
+
+    // Neighbour sums stay within twice the absolute row weight, so int16 lanes are
+    // safe whenever that and the threshold fit.
+    for (int r = 0; r < rows; ++r) {
+        long long bound = abs(static_cast<long long>(system.thresholds[r]));
+        for (int j = 0; j < num_vars; ++j) bound += 2LL * abs(system.row(r)[j]);
+        if (bound >= numeric_limits<int16_t>::max()) narrow = false;
+    }
+
+    padded_rows = (rows + 15) / 16 * 16;
+    columns32.assign(static_cast<size_t>(num_vars) * padded_rows, 0);
+    diagonal32.assign(padded_rows, 0);
+    // Padding rows always hold and belong to no node.
+    thresholds32.assign(padded_rows, numeric_limits<int32_t>::min() / 2);
+    for (int r = 0; r < rows; ++r) {
+        for (int j = 0; j < num_vars; ++j) {
+            columns32[static_cast<size_t>(j) * padded_rows + r] = system.row(r)[j];
+        }
+        diagonal32[r] = system.row(r)[row_node[r]];
+        thresholds32[r] = system.thresholds[r];
+    }
+
+    if (narrow) {
+        columns16.assign(columns32.begin(), columns32.end());
+        diagonal16.assign(diagonal32.begin(), diagonal32.end());
+        thresholds16.resize(padded_rows);
+        for (int r = 0; r < padded_rows; ++r) {
+            thresholds16[r] = r < rows ? thresholds32[r] : numeric_limits<int16_t>::min();
+        }
+    }
+
+#ifdef AILP_AVX2_KERNEL
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+void FrontierBlockKernel::evaluate(const uint64_t* states, size_t count, uint64_t* predecessor_masks) const {
+    vector<int32_t> sums(padded_rows);
+    vector<int32_t> flip_mask32(padded_rows, 0);
+    vector<int16_t> flip_mask16(padded_rows, 0);
+    vector<uint8_t> row_ok(padded_rows);
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t x = states[i];
+        for (int r = 0; r < rows; ++r) {
+            flip_mask32[r] = -static_cast<int32_t>((x >> row_node[r]) & 1);
+            flip_mask16[r] = static_cast<int16_t>(flip_mask32[r]);
+        }
+
+#ifdef AILP_AVX2_KERNEL
+        if (avx2 && narrow) {
+            rows_avx2_16(x, padded_rows, columns16.data(), diagonal16.data(), thresholds16.data(),
+                         flip_mask16.data(), row_ok.data());
+        } else if (avx2) {
+            rows_avx2_32(x, padded_rows, columns32.data(), diagonal32.data(), thresholds32.data(),
+                         flip_mask32.data(), row_ok.data());
+        } else
+#endif
+        {
+            rows_scalar(x, padded_rows, columns32.data(), diagonal32.data(), thresholds32.data(),
+                        flip_mask32.data(), sums.data(), row_ok.data());
+        }
+
+        // Flipping j gives a predecessor iff f_j of the neighbour equals x_j.
+        uint64_t mask = 0;
+        for (int j = 0; j < num_vars; ++j) {
+            int f_j = 1;
+            for (int r = row_begin[j]; r < row_begin[j + 1] && f_j; ++r) f_j = row_ok[r];
+            if (f_j == static_cast<int>((x >> j) & 1)) mask |= uint64_t(1) << j;
+        }
+        predecessor_masks[i] = mask;
+    }
+}
+
+long long count_unreachable_states_batched(const ExplorationSystem& system,
+                                           const vector<vector<int>>& initial_cubes,
+                                           uint64_t max_states,
+                                           const SearchCancelled& cancelled) {
+    const int n = system.num_vars;
+    const uint64_t total = uint64_t(1) << n;
+
+    FrontierBlockKernel kernel(system);
+    VisitedSet visited(n);
+    uint64_t reached = 0;
+    uint64_t expanded = 0;
+
+    vector<uint64_t> frontier, next_frontier;
+    for (uint64_t s : expand_cubes(initial_cubes)) {
+        if (visited.test_and_set(s)) continue;
+        reached++;
+        frontier.push_back(s);
+    }
+
+    uint64_t masks[FrontierBlockKernel::BLOCK_SIZE];
+    while (!frontier.empty() && reached < total) {
+        if (cancelled && cancelled()) return -1;
+        next_frontier.clear();
+
+        for (size_t b = 0; b < frontier.size(); b += FrontierBlockKernel::BLOCK_SIZE) {
+            size_t count = min(FrontierBlockKernel::BLOCK_SIZE, frontier.size() - b);
+            expanded += count;
+            if (max_states && expanded > max_states) return -1;
+
+            kernel.evaluate(frontier.data() + b, count, masks);
+            for (size_t i = 0; i < count; ++i) {
+                for (uint64_t bits = masks[i]; bits; bits &= bits - 1) {
+                    uint64_t y = frontier[b + i] ^ (uint64_t(1) << __builtin_ctzll(bits));
+                    if (visited.test_and_set(y)) continue;
+                    reached++;
+                    next_frontier.push_back(y);
+                }
+            }
+        }
+
+        swap(frontier, next_frontier);
+    }
+
+    return static_cast<long long>(total - reached);
+}
+
+long long count_unreachable_states_parallel(const ExplorationSystem& system,
+                                            const vector<vector<int>>& initial_cubes,
+                                            int threads,
+                                            uint64_t max_states,
+                                            const SearchCancelled& cancelled) {
+    const int n = system.num_vars;
+    const uint64_t total = uint64_t(1) << n;
+    const size_t block = FrontierBlockKernel::BLOCK_SIZE;
+
+    FrontierBlockKernel kernel(system);
+    AtomicVisitedSet visited(n);
+    atomic<uint64_t> reached(0);
+    atomic<uint64_t> expanded(0);
+    atomic<bool> over_budget(false);
+
+    vector<uint64_t> frontier;
+    for (uint64_t s : expand_cubes(initial_cubes)) {
+        if (visited.test_and_set(s)) continue;
+        reached++;
+        frontier.push_back(s);
+    }
+
+    vector<vector<uint64_t>> local_next(threads);
+    while (!frontier.empty() && reached.load() < total) {
+        if (cancelled && cancelled()) return -1;
+        atomic<size_t> next_block(0);
+
+        auto worker = [&](int id) {
+            vector<uint64_t>& out = local_next[id];
+            out.clear();
+            uint64_t masks[FrontierBlockKernel::BLOCK_SIZE];
+
+            while (true) {
+                size_t b = next_block.fetch_add(block);
+                if (b >= frontier.size() || over_budget.load(memory_order_relaxed)) break;
+                if (reached.load(memory_order_relaxed) >= total) break;
+
+                size_t count = min(block, frontier.size() - b);
+                if (max_states && expanded.fetch_add(count) + count > max_states) {
+                    over_budget = true;
+                    break;
+                }
+
+                kernel.evaluate(frontier.data() + b, count, masks);
+                uint64_t found = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    for (uint64_t bits = masks[i]; bits; bits &= bits - 1) {
+                        uint64_t y = frontier[b + i] ^ (uint64_t(1) << __builtin_ctzll(bits));
+                        if (visited.test_and_set(y)) continue;
+                        found++;
+                        out.push_back(y);
+                    }
+                }
+                reached.fetch_add(found, memory_order_relaxed);
+            }
+        };
+
+        // Narrow levels are not worth a thread launch.
+        int level_threads = static_cast<int>(min<size_t>(threads, (frontier.size() + block - 1) / block));
+        if (level_threads <= 1) {
+            worker(0);
+            for (int t = 1; t < threads; ++t) local_next[t].clear();
+        } else {
+            vector<thread> pool;
+            for (int t = 0; t < level_threads; ++t) pool.emplace_back(worker, t);
+            for (auto& th : pool) th.join();
+            for (int t = level_threads; t < threads; ++t) local_next[t].clear();
+        }
+        if (over_budget) return -1;
+
+        frontier.clear();
+        for (auto& out : local_next) frontier.insert(frontier.end(), out.begin(), out.end());
+    }
+
+    return static_cast<long long>(total - reached.load());
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "ScenarioSweep.h"
+#include "ILPModelBuilder.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+vector<map<int, int>> enumerate_scenario(ILPModel& ilp_model, const map<int, int>& scenario, int free_size,
+                                         const PercolationResult& percolation,
+                                         const vector<NodePermutation>& symmetries) {
+    AILP_TRACE_SCOPE(scope, "sweep.scenario");
+    for (const auto& [ext, v] : scenario) {
+        if (ext >= static_cast<int>(ilp_model.externals_vars.size())) continue;
+        ilp_model.externals_vars[ext].set(GRB_DoubleAttr_LB, v);
+        ilp_model.externals_vars[ext].set(GRB_DoubleAttr_UB, v);
+    }
+
+    // Nodes the scenario forces are fixed in every solution, so the sizes below cover
+    // the percolated space of the scenario as well.
+    vector<map<int, int>> trap_spaces = enumerate_by_size(ilp_model, free_size);
+    if (trap_spaces.empty()) trap_spaces.push_back(percolation.forced_states);
+    if (!symmetries.empty() && enumeration_options.expand_orbits) {
+        trap_spaces = expand_orbits(trap_spaces, symmetries);
+    }
+    return trap_spaces;
+}
+
+}
+
+vector<map<int, int>> read_scenarios(BooleanNetwork& network, const string& path) {
+    ifstream in(path);
+    if (!in.is_open()) throw invalid_argument("cannot open scenario file " + path);
+
+    vector<map<int, int>> scenarios;
+    string line;
+    while (getline(in, line)) {
+        line.erase(remove_if(line.begin(), line.end(), [](char c) { return isspace(static_cast<unsigned char>(c)); }),
+                   line.end());
+        if (line.empty() || line[0] == '#') continue;
+
+        map<int, int> scenario;
+        stringstream items(line == "-" ? "" : line);
+        for (string item; getline(items, item, ',');) {
+            size_t eq = item.find('=');
+            auto it = eq == string::npos ? network.nodes.end() : network.nodes.find(item.substr(0, eq));
+            if (it == network.nodes.end()) throw invalid_argument("bad scenario entry " + item);
+            int ext = it->second->id - network.state_size;
+            string value = item.substr(eq + 1);
+            if (ext < 0 || ext >= network.external_size || (value != "0" && value != "1")) {
+                throw invalid_argument("bad scenario entry " + item);
+            }
+            scenario[ext] = value == "1";
+        }
+        scenarios.push_back(scenario);
+    }
+    return scenarios;
+}
+
+ScenarioSweepResult sweep_scenarios(BooleanNetwork& network, const vector<map<int, int>>& scenarios) {
+    AILP_TRACE_SCOPE(scope, "sweep_scenarios");
+    ScenarioSweepResult result;
+    result.scenarios = scenarios;
+    vector<vector<map<int, int>>> per_scenario(scenarios.size());
+
+    PercolationResult percolation = get_percolation(network, {});
+    int free_size = percolation.free_states.size();
+
+    if (free_size == 0) {
+        for (auto& spaces : per_scenario) spaces = {percolation.forced_states};
+    } else if (!scenarios.empty()) {
+        vector<int> branch_nodes;
+        if (enumeration_options.use_fvs) branch_nodes = get_feedback_vertex_set(network, percolation.free_states);
+        // Symmetries leave the externals in place, so the rows hold under every scenario
+        vector<NodePermutation> symmetries;
+        if (enumeration_options.break_symmetries && !enumeration_options.minimal_only) {
+            symmetries = find_symmetries(network, percolation);
+        }
+
+        ILPModel base_model = build_ilp_model(network, free_size, percolation, branch_nodes);
+        add_symmetry_breaking_constraints(base_model, symmetries);
+        base_model.model.update();
+
+        mutex base_lock;
+        atomic<size_t> next_scenario(0);
+        vector<exception_ptr> errors(scenarios.size());
+        auto worker = [&]() {
+            try {
+                GRBEnv env;
+                env.set(GRB_IntParam_OutputFlag, 0);
+                unique_ptr<ILPModel> thread_base;
+                {
+                    lock_guard<mutex> guard(base_lock);
+                    thread_base = make_unique<ILPModel>(copy_ilp_model(base_model, env));
+                }
+                for (size_t s = next_scenario++; s < scenarios.size(); s = next_scenario++) {
+                    try {
+                        ILPModel ilp_model = copy_ilp_model(*thread_base, env);
+                        per_scenario[s] = enumerate_scenario(ilp_model, scenarios[s], free_size, percolation, symmetries);
+                    } catch (...) {
+                        errors[s] = current_exception();
+                    }
+                }
+            } catch (...) {
+                // Environment or copy failure: report it on the scenario that would run next
+                size_t s = next_scenario++;
+                if (s < errors.size()) errors[s] = current_exception();
+            }
+        };
+
+        int threads = enumeration_options.threads > 0 ? enumeration_options.threads
+                                                      : static_cast<int>(thread::hardware_concurrency());
+        threads = max(1, min<int>(threads, scenarios.size()));
+        vector<thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool) th.join();
+
+        for (const auto& e : errors) {
+            if (e) rethrow_exception(e);
+        }
+    }
+
+    // One row per distinct space, in order of first appearance within each size
+    map<map<int, int>, size_t> row_of;
+    for (size_t s = 0; s < per_scenario.size(); ++s) {
+        for (const auto& space : per_scenario[s]) {
+            auto [it, inserted] = row_of.emplace(space, result.trap_spaces.size());
+            if (inserted) {
+                result.trap_spaces.push_back(space);
+                result.scenarios_of.emplace_back();
+            }
+            auto& rows = result.scenarios_of[it->second];
+            if (rows.empty() || rows.back() != static_cast<int>(s)) rows.push_back(s);
+        }
+    }
+    vector<size_t> order(result.trap_spaces.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return result.trap_spaces[a].size() > result.trap_spaces[b].size();
+    });
+    ScenarioSweepResult sorted;
+    sorted.scenarios = move(result.scenarios);
+    for (size_t i : order) {
+        sorted.trap_spaces.push_back(move(result.trap_spaces[i]));
+        sorted.scenarios_of.push_back(move(result.scenarios_of[i]));
+    }
+
+    cout << "Sweep: " << scenarios.size() << " scenarios, " << sorted.trap_spaces.size()
+         << " distinct trap spaces" << endl;
+    return sorted;
+}
+
+bool write_sweep_table(const BooleanNetwork& network, const ScenarioSweepResult& result, const string& path) {
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    out << "trap_space\tfixed\tscenarios\n";
+    for (size_t i = 0; i < result.trap_spaces.size(); ++i) {
+        const auto& space = result.trap_spaces[i];
+        string nodes;
+        for (const auto& [id, v] : space) {
+            if (!nodes.empty()) nodes += ",";
+            nodes += network.index_to_name[id] + "=" + to_string(v);
+        }
+        string scenarios;
+        for (int s : result.scenarios_of[i]) {
+            if (!scenarios.empty()) scenarios += ",";
+            scenarios += to_string(s);
+        }
+        out << (nodes.empty() ? "-" : nodes) << "\t" << space.size() << "\t" << scenarios << "\n";
+    }
+    return static_cast<bool>(out);
+}
@@ -2,6 +2,15 @@
 #include <algorithm>
 #include <iostream>
 
+const char* verification_status_name(VerificationStatus status) {
+    switch (status) {
+        case VerificationStatus::Verified: return "verified";
+        case VerificationStatus::Unverified: return "unverified";
+        case VerificationStatus::SkippedForBudget: return "skipped_for_budget";
+    }
+    return "";
+}
+
 SolutionObjects::SolutionObjects() 
     : solution_id_counter(0), external_id_counter(0) {}
 
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+
+#include "SymbolicReachability.h"
+#include "Budget.h"
+
+using namespace std;
+
+namespace {
+// Refs are packed into 25 bits and variables into 14 bits in the table keys.
+const size_t MAX_BDD_NODES = (size_t(1) << 25) - 1;
+const size_t ITE_CACHE_SIZE = size_t(1) << 20;
+
+uint64_t unique_key(int v, int low, int high) {
+    return (uint64_t(v) << 50) | (uint64_t(low) << 25) | uint64_t(high);
+}
+}
+
+BddManager::BddManager(int num_vars, size_t node_limit)
+    : num_vars(num_vars), node_limit(min(node_limit, MAX_BDD_NODES)), ite_cache(ITE_CACHE_SIZE) {
+    // Terminals sit below every variable.
+    nodes.push_back({num_vars, 0, 0});
+    nodes.push_back({num_vars, 1, 1});
+}
+
+BddManager::Ref BddManager::make_node(int v, Ref low, Ref high) {
+    if (low == high) return low;
+
+    uint64_t key = unique_key(v, low, high);
+    auto it = unique_table.find(key);
+    if (it != unique_table.end()) return it->second;
+
+    if (nodes.size() >= node_limit) throw BddNodeLimitExceeded();
+
+    Ref r = static_cast<Ref>(nodes.size());
+    nodes.push_back({v, low, high});
+    unique_table.emplace(key, r);
+    return r;
+}
+
+BddManager::Ref BddManager::var(int v) {
+    return make_node(v, zero(), one());
+}
+
+BddManager::Ref BddManager::restrict_top(Ref f, int v, bool value) const {
+    if (top_var(f) != v) return f;
+    return value ? nodes[f].high : nodes[f].low;
+}
+
+BddManager::Ref BddManager::ite(Ref f, Ref g, Ref h) {
+    if (f == one()) return g;
+    if (f == zero()) return h;
+    if (g == h) return g;
+    if (g == one() && h == zero()) return f;
+
+    size_t slot = (size_t(f) * 12582917u + size_t(g) * 4256249u + size_t(h) * 741457u) & (ITE_CACHE_SIZE - 1);
+    IteEntry& entry = ite_cache[slot];
+    if (entry.f == f && entry.g == g && entry.h == h) return entry.result;
+
+    int v = min({top_var(f), top_var(g), top_var(h)});
+    Ref low = ite(restrict_top(f, v, false), restrict_top(g, v, false), restrict_top(h, v, false));
+    Ref high = ite(restrict_top(f, v, true), restrict_top(g, v, true), restrict_top(h, v, true));
+    Ref r = make_node(v, low, high);
+
+    // The recursion may have reused the slot; store the final entry.
+    ite_cache[slot] = {f, g, h, r};
+    return r;
+}
+
+BddManager::Ref BddManager::cofactor(Ref f, int v, bool value) {
+    if (top_var(f) > v) return f;
+    if (top_var(f) == v) return value ? nodes[f].high : nodes[f].low;
+
+    uint64_t key = (uint64_t(f) << 15) | (uint64_t(v) << 1) | uint64_t(value);
+    auto it = cofactor_cache.find(key);
+    if (it != cofactor_cache.end()) return it->second;
+
+    Ref r = make_node(top_var(f), cofactor(nodes[f].low, v, value), cofactor(nodes[f].high, v, value));
+    cofactor_cache.emplace(key, r);
+    return r;
+}
+
+BddManager::Ref BddManager::swap_var(Ref f, int v) {
+    return ite(var(v), cofactor(f, v, false), cofactor(f, v, true));
+}
+
+BddManager::Ref BddManager::threshold(const int* weights, int threshold) {
+    // Suffix bounds of the weighted sum decide a subtree without expanding it.
+    vector<long long> min_rest(num_vars + 1, 0), max_rest(num_vars + 1, 0);
+    for (int v = num_vars - 1; v >= 0; --v) {
+        min_rest[v] = min_rest[v + 1] + min(0, weights[v]);
+        max_rest[v] = max_rest[v + 1] + max(0, weights[v]);
+    }
+
+    map<pair<int, long long>, Ref> memo;
+    function<Ref(int, long long)> build = [&](int v, long long sum) -> Ref {
+        if (sum + min_rest[v] >= threshold) return one();
+        if (sum + max_rest[v] < threshold) return zero();
+
+        auto key = make_pair(v, sum);
+        auto it = memo.find(key);
+        if (it != memo.end()) return it->second;
+
+        Ref r = make_node(v, build(v + 1, sum), build(v + 1, sum + weights[v]));
+        memo.emplace(key, r);
+        return r;
+    };
+    return build(0, 0);
+}
+
+BddManager::Ref BddManager::cube(const vector<int>& values) {
+    Ref r = one();
+    for (int v = num_vars - 1; v >= 0; --v) {
+        if (values[v] == 1) r = make_node(v, zero(), r);
+        else if (values[v] == 0) r = make_node(v, r, zero());
+    }
+    return r;
+}
+
+double BddManager::sat_count(Ref f) {
+    map<Ref, double> memo;
+    function<double(Ref)> count = [&](Ref g) -> double {
+        if (g == zero()) return 0.0;
+        if (g == one()) return 1.0;
+
+        auto it = memo.find(g);
+        if (it != memo.end()) return it->second;
+
+        const BddNode& node = nodes[g];
+        double c = count(node.low) * ldexp(1.0, top_var(node.low) - node.var - 1)
+                 + count(node.high) * ldexp(1.0, top_var(node.high) - node.var - 1);
+        memo.emplace(g, c);
+        return c;
+    };
+    return count(f) * ldexp(1.0, top_var(f));
+}
+
+vector<BddManager::Ref> symbolic_enabled_flips(BddManager& bdd, const ExplorationSystem& system) {
+    vector<BddManager::Ref> enabled_flips(system.num_vars);
+    for (int v = 0; v < system.num_vars; ++v) {
+        BddManager::Ref f = bdd.one();
+        for (int r = system.row_begin[v]; r < system.row_begin[v + 1]; ++r) {
+            f = bdd.apply_and(f, bdd.threshold(system.row(r), system.thresholds[r]));
+        }
+        enabled_flips[v] = bdd.apply_xor(bdd.var(v), f);
+    }
+    return enabled_flips;
+}
+
+BddManager::Ref symbolic_preimage(BddManager& bdd, const vector<BddManager::Ref>& enabled_flips,
+                                  BddManager::Ref states) {
+    BddManager::Ref result = bdd.zero();
+    for (size_t v = 0; v < enabled_flips.size(); ++v) {
+        result = bdd.apply_or(result, bdd.apply_and(enabled_flips[v], bdd.swap_var(states, v)));
+    }
+    return result;
+}
+
+BddManager::Ref symbolic_image(BddManager& bdd, const vector<BddManager::Ref>& enabled_flips,
+                               BddManager::Ref states) {
+    BddManager::Ref result = bdd.zero();
+    for (size_t v = 0; v < enabled_flips.size(); ++v) {
+        result = bdd.apply_or(result, bdd.swap_var(bdd.apply_and(states, enabled_flips[v]), v));
+    }
+    return result;
+}
+
+double symbolic_count_unreachable_states(const ExplorationSystem& system,
+                                         const vector<vector<int>>& initial_cubes,
+                                         size_t node_limit) {
+    try {
+        BddManager bdd(system.num_vars, node_limit);
+        auto enabled_flips = symbolic_enabled_flips(bdd, system);
+
+        BddManager::Ref reached = bdd.zero();
+        for (const auto& c : initial_cubes) {
+            reached = bdd.apply_or(reached, bdd.cube(c));
+        }
+
+        // Backward fixpoint: only the newly added states need a preimage each round.
+        BddManager::Ref frontier = reached;
+        while (frontier != bdd.zero()) {
+            if (budget_exhausted(BudgetPhase::Inclusion)) return -1;
+            BddManager::Ref pre = symbolic_preimage(bdd, enabled_flips, frontier);
+            frontier = bdd.apply_and(pre, bdd.negate(reached));
+            reached = bdd.apply_or(reached, frontier);
+        }
+
+        return ldexp(1.0, system.num_vars) - bdd.sat_count(reached);
+    } catch (const BddNodeLimitExceeded&) {
+        cout << "symbolic reachability: node limit reached for " << system.num_vars << " nodes" << endl;
+        return -1;
+    }
+}
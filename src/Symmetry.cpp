@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <tuple>
+
+#include "Symmetry.h"
+
+using namespace std;
+
+namespace {
+
+// Reduced functions of the free nodes as weighted edge lists between free nodes plus
+// everything else (thresholds, static flag, self weights, other inputs) that has to
+// match. An edge carries the parent's weight in every threshold row of the child.
+struct InteractionGraph {
+    vector<int> nodes;
+    map<int, map<int, vector<int>>> in;     // node -> parent -> row weights
+    map<int, map<int, vector<int>>> out;    // node -> child -> row weights
+    map<int, vector<int>> invariant;
+
+    vector<int> weight(int from, int to) const {
+        auto it = out.find(from);
+        if (it == out.end()) return {};
+        auto w = it->second.find(to);
+        return w == it->second.end() ? vector<int>{} : w->second;
+    }
+};
+
+InteractionGraph build_interaction_graph(const BooleanNetwork& network, const PercolationResult& percolation) {
+    InteractionGraph graph;
+    graph.nodes = percolation.free_states;
+    set<int> free(graph.nodes.begin(), graph.nodes.end());
+
+    for (int k : graph.nodes) {
+        ThresholdFunctions rows = reduce_threshold_functions(network.threshold_functions.at(k),
+                                                             percolation.known_inputs);
+        bool is_static = k < static_cast<int>(network.index_to_name.size())
+                         && network.nodes.count(network.index_to_name[k])
+                         && network.nodes.at(network.index_to_name[k])->static_flag;
+
+        vector<int> invariant = {static_cast<int>(rows.size()), is_static ? 1 : 0};
+        map<int, vector<int>> edges;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            const auto& [weights, threshold] = rows[r];
+            invariant.push_back(threshold);
+            for (size_t p = 0; p < weights.size(); ++p) {
+                int w = weights[p];
+                if (w == 0) continue;
+                if (free.count(p) && static_cast<int>(p) != k) {
+                    auto& edge = edges[p];
+                    edge.resize(rows.size(), 0);
+                    edge[r] = w;
+                } else {
+                    // Self-loops and externals stay in place under every permutation
+                    invariant.push_back(static_cast<int>(r));
+                    invariant.push_back(static_cast<int>(p) == k ? -1 : p);
+                    invariant.push_back(w);
+                }
+            }
+        }
+        for (const auto& [p, edge] : edges) {
+            graph.in[k][p] = edge;
+            graph.out[p][k] = edge;
+        }
+        graph.invariant[k] = invariant;
+    }
+    return graph;
+}
+
+// Colour refinement: nodes start from their invariants and are split by the multiset of
+// (row weights, colour) over their parents and over their children until stable.
+map<int, int> refine_colors(const InteractionGraph& graph) {
+    map<int, int> color;
+    {
+        map<vector<int>, int> ids;
+        for (int k : graph.nodes) {
+            auto it = ids.emplace(graph.invariant.at(k), ids.size()).first;
+            color[k] = it->second;
+        }
+    }
+
+    size_t classes = 0;
+    while (true) {
+        map<tuple<int, vector<pair<vector<int>, int>>, vector<pair<vector<int>, int>>>, int> ids;
+        map<int, int> next;
+        for (int k : graph.nodes) {
+            vector<pair<vector<int>, int>> parents, children;
+            if (graph.in.count(k)) {
+                for (const auto& [p, w] : graph.in.at(k)) parents.emplace_back(w, color[p]);
+            }
+            if (graph.out.count(k)) {
+                for (const auto& [c, w] : graph.out.at(k)) children.emplace_back(w, color[c]);
+            }
+            sort(parents.begin(), parents.end());
+            sort(children.begin(), children.end());
+            auto key = make_tuple(color[k], parents, children);
+            auto it = ids.emplace(key, ids.size()).first;
+            next[k] = it->second;
+        }
+        color = next;
+        if (ids.size() == classes) break;
+        classes = ids.size();
+    }
+    return color;
+}
+
+bool is_automorphism(const InteractionGraph& graph, const NodePermutation& perm) {
+    for (int k : graph.nodes) {
+        if (graph.invariant.at(k) != graph.invariant.at(perm[k])) return false;
+        if (!graph.in.count(k)) {
+            if (graph.in.count(perm[k]) && !graph.in.at(perm[k]).empty()) return false;
+            continue;
+        }
+        const auto& parents = graph.in.at(k);
+        if (!graph.in.count(perm[k]) || graph.in.at(perm[k]).size() != parents.size()) return false;
+        for (const auto& [p, w] : parents) {
+            if (graph.weight(perm[p], perm[k]) != w) return false;
+        }
+    }
+    return true;
+}
+
+// Backtracking search for an automorphism with perm[a] == b. Nodes are matched in
+// breadth-first order from a; a candidate must share the colour of the node and agree
+// on every edge to the nodes matched so far.
+bool find_automorphism(const InteractionGraph& graph, const map<int, int>& color, int a, int b,
+                       int max_steps, NodePermutation& perm) {
+    vector<int> order;
+    set<int> placed;
+    auto visit_from = [&](int root) {
+        if (!placed.insert(root).second) return;
+        order.push_back(root);
+        for (size_t i = order.size() - 1; i < order.size(); ++i) {
+            vector<int> neighbours;
+            if (graph.in.count(order[i])) {
+                for (const auto& [p, w] : graph.in.at(order[i])) neighbours.push_back(p);
+            }
+            if (graph.out.count(order[i])) {
+                for (const auto& [c, w] : graph.out.at(order[i])) neighbours.push_back(c);
+            }
+            for (int v : neighbours) {
+                if (placed.insert(v).second) order.push_back(v);
+            }
+        }
+    };
+    visit_from(a);
+    for (int k : graph.nodes) visit_from(k);
+
+    map<int, vector<int>> by_color;
+    for (int k : graph.nodes) by_color[color.at(k)].push_back(k);
+
+    map<int, int> image, preimage;
+    int steps = 0;
+
+    auto consistent = [&](int u, int v) {
+        if (graph.in.count(u)) {
+            for (const auto& [p, w] : graph.in.at(u)) {
+                if (image.count(p) && graph.weight(image[p], v) != w) return false;
+            }
+        }
+        if (graph.out.count(u)) {
+            for (const auto& [c, w] : graph.out.at(u)) {
+                if (image.count(c) && graph.weight(v, image[c]) != w) return false;
+            }
+        }
+        // No extra edges between v and the images matched so far
+        if (graph.in.count(v)) {
+            for (const auto& [p, w] : graph.in.at(v)) {
+                if (preimage.count(p) && graph.weight(preimage[p], u) != w) return false;
+            }
+        }
+        if (graph.out.count(v)) {
+            for (const auto& [c, w] : graph.out.at(v)) {
+                if (preimage.count(c) && graph.weight(u, preimage[c]) != w) return false;
+            }
+        }
+        return true;
+    };
+
+    function<bool(size_t)> extend = [&](size_t i) {
+        if (i == order.size()) return true;
+        int u = order[i];
+        vector<int> candidates;
+        if (u == a) {
+            candidates.push_back(b);
+        } else {
+            // The identity first keeps generators small
+            candidates.push_back(u);
+            for (int v : by_color[color.at(u)]) {
+                if (v != u) candidates.push_back(v);
+            }
+        }
+        for (int v : candidates) {
+            if (preimage.count(v) || color.at(v) != color.at(u)) continue;
+            if (++steps > max_steps) return false;
+            if (!consistent(u, v)) continue;
+            image[u] = v;
+            preimage[v] = u;
+            if (extend(i + 1)) return true;
+            image.erase(u);
+            preimage.erase(v);
+            if (steps > max_steps) return false;
+        }
+        return false;
+    };
+
+    if (!extend(0)) return false;
+    for (const auto& [u, v] : image) perm[u] = v;
+    return is_automorphism(graph, perm);
+}
+
+int find_orbit(vector<int>& parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+}
+
+vector<NodePermutation> find_symmetries(const BooleanNetwork& network,
+                                        const PercolationResult& percolation,
+                                        int max_search_steps) {
+    vector<NodePermutation> generators;
+    InteractionGraph graph = build_interaction_graph(network, percolation);
+    if (graph.nodes.size() < 2) return generators;
+
+    map<int, int> color = refine_colors(graph);
+    map<int, vector<int>> classes;
+    for (int k : graph.nodes) classes[color[k]].push_back(k);
+
+    const int state_size = network.state_size;
+    vector<int> orbit(state_size);
+    for (int i = 0; i < state_size; ++i) orbit[i] = i;
+
+    for (const auto& [c, members] : classes) {
+        for (size_t j = 1; j < members.size(); ++j) {
+            int a = members[0], b = members[j];
+            if (find_orbit(orbit, a) == find_orbit(orbit, b)) continue;
+
+            NodePermutation perm(state_size);
+            for (int i = 0; i < state_size; ++i) perm[i] = i;
+            if (!find_automorphism(graph, color, a, b, max_search_steps, perm)) continue;
+
+            generators.push_back(perm);
+            for (int k : graph.nodes) {
+                int x = find_orbit(orbit, k), y = find_orbit(orbit, perm[k]);
+                if (x != y) orbit[max(x, y)] = min(x, y);
+            }
+        }
+    }
+
+    if (!generators.empty()) {
+        cout << "Symmetry: " << generators.size() << " generators over "
+             << classes.size() << " colour classes" << endl;
+    }
+    return generators;
+}
+
+vector<map<int, int>> expand_orbits(const vector<map<int, int>>& trap_spaces,
+                                    const vector<NodePermutation>& generators) {
+    vector<map<int, int>> result;
+    set<map<int, int>> seen;
+    for (const auto& t : trap_spaces) {
+        if (seen.insert(t).second) result.push_back(t);
+    }
+    if (generators.empty()) return result;
+
+    size_t originals = result.size();
+    for (size_t i = 0; i < result.size(); ++i) {
+        for (const auto& perm : generators) {
+            map<int, int> image;
+            for (const auto& [k, v] : result[i]) {
+                image[k < static_cast<int>(perm.size()) ? perm[k] : k] = v;
+            }
+            if (seen.insert(image).second) result.push_back(move(image));
+        }
+    }
+
+    // Images of a space have its size; keep the largest-first order of the input
+    stable_sort(result.begin() + originals, result.end(), [](const map<int, int>& x, const map<int, int>& y) {
+        return x.size() > y.size();
+    });
+    vector<map<int, int>> ordered;
+    ordered.reserve(result.size());
+    merge(result.begin(), result.begin() + originals, result.begin() + originals, result.end(),
+          back_inserter(ordered), [](const map<int, int>& x, const map<int, int>& y) {
+              return x.size() > y.size();
+          });
+    return ordered;
+}
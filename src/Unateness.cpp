@@ -0,0 +1,63 @@
+#include "Unateness.h"
+
+using namespace std;
+
+vector<uint64_t> threshold_truth_table(const vector<int>& weights, int threshold) {
+    const int n = weights.size();
+    const uint64_t assignments = uint64_t(1) << n;
+    vector<uint64_t> table(max<uint64_t>(1, assignments / 64), 0);
+
+    // Gray-code walk: every step flips one input, so the sum is updated in O(1).
+    long long sum = 0;
+    uint64_t state = 0;
+    for (uint64_t g = 0; g < assignments; ++g) {
+        if (g > 0) {
+            int i = __builtin_ctzll(g);
+            state ^= uint64_t(1) << i;
+            sum += ((state >> i) & 1) ? weights[i] : -weights[i];
+        }
+        if (sum >= threshold) table[state >> 6] |= uint64_t(1) << (state & 63);
+    }
+
+    if (assignments < 64) {
+        for (uint64_t m = assignments; m < 64; m += assignments) {
+            table[0] |= (table[0] & ((uint64_t(1) << assignments) - 1)) << m;
+        }
+    }
+    return table;
+}
+
+vector<Unateness> get_unateness(const vector<uint64_t>& table, int num_inputs) {
+    // Bits whose input i is 0, for the inputs inside one word
+    static const uint64_t low_half[6] = {
+        0x5555555555555555ULL, 0x3333333333333333ULL, 0x0F0F0F0F0F0F0F0FULL,
+        0x00FF00FF00FF00FFULL, 0x0000FFFF0000FFFFULL, 0x00000000FFFFFFFFULL,
+    };
+
+    vector<Unateness> result(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+        uint64_t rises = 0, falls = 0;
+        if (i < 6) {
+            int shift = 1 << i;
+            for (uint64_t word : table) {
+                uint64_t f0 = word & low_half[i];
+                uint64_t f1 = (word >> shift) & low_half[i];
+                rises |= ~f0 & f1;
+                falls |= f0 & ~f1;
+            }
+        } else {
+            size_t stride = size_t(1) << (i - 6);
+            for (size_t w = 0; w < table.size(); ++w) {
+                if (w & stride) continue;
+                rises |= ~table[w] & table[w + stride];
+                falls |= table[w] & ~table[w + stride];
+            }
+        }
+
+        if (rises && falls) result[i] = Unateness::Binate;
+        else if (rises) result[i] = Unateness::Positive;
+        else if (falls) result[i] = Unateness::Negative;
+        else result[i] = Unateness::Independent;
+    }
+    return result;
+}
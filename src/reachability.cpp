@@ -7,413 +7,415 @@
 #include <bitset>
 #include <functional>
 #include <list>
+#include <memory_resource>
 #include <numeric>
+#include <limits>
+#include <random>
+#include <thread>
 
 #include "BooleanNetwork.h"
 #include "SolutionObjects.h"
+#include "Reachability.h"
+#include "DecomposedReachability.h"
+#include "OutOfCoreReachability.h"
+#include "ReachabilityKernel.h"
+#include "SymbolicReachability.h"
+#include "Instrumentation.h"
+#include "Budget.h"
 
 using namespace std;
 
-// Helper function to generate all combinations
-vector<vector<int>> generate_combinations(int n) {
-    vector<vector<int>> result;
-    for(int i=0; i<(1<<n); ++i) {
-        vector<int> combo;
-        for(int j=0; j<n; ++j) {
-            combo.push_back((i >> j) & 1);
+vector<int> get_included_solution_cube(const TrapSpace& included_solution,
+                                       const vector<int>& state_to_explore) {
+    vector<int> cube(state_to_explore.size(), -1);
+    for(size_t i=0; i<state_to_explore.size(); ++i) {
+        auto it = included_solution.stable_nodes.find(state_to_explore[i]);
+        if(it != included_solution.stable_nodes.end()) {
+            cube[i] = it->second;
         }
-        result.push_back(combo);
     }
-    return result;
+    return cube;
 }
 
-vector<int> get_nodes_to_explore(const BooleanNetwork& network,
-                               const map<int, vector<pair<map<int, int>, int>>>& exploration_functions,
-                               const set<int>& not_included_nodes) {
-    set<int> state_to_explore;
-    for(const auto& [k, v] : exploration_functions) {
-        if(not_included_nodes.count(k)) {
-            for(const auto& [f, _] : v) {
-                for(const auto& [i, _] : f) {
-                    state_to_explore.insert(i);
-                }
-            }
+static bool in_any_cube(const vector<char>& state, const vector<vector<int>>& cubes) {
+    for(const auto& c : cubes) {
+        bool inside = true;
+        for(size_t i=0; i<c.size() && inside; ++i) {
+            if(c[i] != -1 && c[i] != state[i]) inside = false;
         }
+        if(inside) return true;
     }
+    return false;
+}
 
-    bool updated = true;
-    while(updated) {
-        updated = false;
-        vector<int> to_add;
-        for(int node_id : state_to_explore) {
-            for(const auto& [f, _] : exploration_functions.at(node_id)) {
-                for(const auto& [k, _] : f) {
-                    if(!state_to_explore.count(k)) {
-                        to_add.push_back(k);
-                        updated = true;
-                    }
-                }
-            }
+static int evaluate_node(const ExplorationSystem& system, int v, const vector<char>& state) {
+    for(int r = system.row_begin[v]; r < system.row_begin[v + 1]; ++r) {
+        const int* w = system.row(r);
+        int sum = 0;
+        for(int j=0; j<system.num_vars; ++j) {
+            if(state[j]) sum += w[j];
         }
-        for(int x : to_add) state_to_explore.insert(x);
+        if(sum < system.thresholds[r]) return 0;
     }
-
-    vector<int> filtered;
-    copy_if(state_to_explore.begin(), state_to_explore.end(), back_inserter(filtered),
-        [&network](int i) { return i < network.state_size; });
-
-    cout << "state_to_explore: " << filtered.size() << endl;
-    return filtered;
+    return 1;
 }
 
-vector<vector<int>> get_included_solutions_states(const TrapSpace& included_solution,
-                                                const vector<int>& state_to_explore) {
-    vector<vector<int>> result(1, vector<int>(state_to_explore.size(), -1));
+SamplingOutcome sample_reachability(const vector<TrapSpace>& included_solutions,
+                                    const ExplorationSystem& system) {
+    const auto& options = reachability_options;
+    if(options.sampling_trajectories <= 0 || system.num_vars == 0) {
+        return SamplingOutcome::Inconclusive;
+    }
 
-    for(size_t i=0; i<state_to_explore.size(); ++i) {
-        int k = state_to_explore[i];
-        auto it = included_solution.stable_nodes.find(k);
-        if(it != included_solution.stable_nodes.end()) {
-            result[0][i] = it->second;
-        }
+    vector<vector<int>> cubes;
+    for(const auto& s : included_solutions) {
+        cubes.push_back(get_included_solution_cube(s, system.node_ids));
     }
 
-    for(size_t i=0; i<state_to_explore.size(); ++i) {
-        int k = state_to_explore[i];
-        if(!included_solution.stable_nodes.count(k)) {
-            vector<vector<int>> new_result;
-            for(auto& row : result) {
-                vector<int> row0 = row;
-                row0[i] = 0;
-                vector<int> row1 = row;
-                row1[i] = 1;
-                new_result.push_back(row0);
-                new_result.push_back(row1);
+    mt19937_64 rng(options.sampling_seed);
+    bernoulli_distribution coin(0.5);
+    sampling_stats.checks++;
+
+    int hits = 0;
+    vector<char> state(system.num_vars);
+    vector<int> unstable;
+    for(int t=0; t<options.sampling_trajectories; ++t) {
+        // Start outside the included subspaces; give up on this trajectory if they cover
+        // (nearly) everything, which the exhaustive check settles quickly anyway.
+        bool started = false;
+        for(int attempt=0; attempt<64 && !started; ++attempt) {
+            for(auto& b : state) b = coin(rng);
+            started = !in_any_cube(state, cubes);
+        }
+        if(!started) continue;
+
+        bool hit = false;
+        for(int step=0; step<options.sampling_trajectory_length; ++step) {
+            unstable.clear();
+            for(int v=0; v<system.num_vars; ++v) {
+                if(evaluate_node(system, v, state) != state[v]) unstable.push_back(v);
             }
-            result = move(new_result);
+            if(unstable.empty()) {
+                // A fixed point outside every included subspace can reach none of them.
+                sampling_stats.traps_found++;
+                sampling_stats.hits += hits;
+                return SamplingOutcome::TrapFound;
+            }
+
+            int v = unstable[uniform_int_distribution<size_t>(0, unstable.size() - 1)(rng)];
+            state[v] = 1 - state[v];
+            if(in_any_cube(state, cubes)) {
+                hit = true;
+                break;
+            }
+        }
+
+        if(hit) {
+            hits++;
+        } else {
+            sampling_stats.misses++;
         }
     }
-    return result;
+
+    sampling_stats.hits += hits;
+    if(hits == options.sampling_trajectories) {
+        sampling_stats.all_reached++;
+        return SamplingOutcome::AllReached;
+    }
+    sampling_stats.inconclusive++;
+    return SamplingOutcome::Inconclusive;
 }
 
 int check_if_reachable(const TrapSpace& solution,
                       const vector<TrapSpace>& included_solutions,
-                      const map<int, vector<pair<map<int, int>, int>>>& exploration_functions) {
-    vector<int> state_to_explore;
-    for(const auto& [k, _] : exploration_functions) {
-        state_to_explore.push_back(k);
+                      const ExplorationSystem& system) {
+    AILP_TRACE_SCOPE(scope, "check_if_reachable");
+    AILP_TRACE_ARG(scope, "num_vars", system.num_vars);
+    AILP_TRACE_COUNT("reachability.checks", 1);
+    vector<vector<int>> initial_cubes;
+    for(const auto& s : included_solutions) {
+        initial_cubes.push_back(get_included_solution_cube(s, system.node_ids));
     }
-    sort(state_to_explore.begin(), state_to_explore.end());
 
-    if(state_to_explore.size() > 23) {
-        cout << "state_to_explore: " << state_to_explore.size() << endl;
-        return -1;
+    const auto& options = reachability_options;
+    int num_vars = system.num_vars;
+    bool fits_in_memory = num_vars <= MAX_EXPLICIT_VARS
+        && (uint64_t(1) << num_vars) / 8 <= options.memory_budget_bytes;
+
+    // Loosely coupled modules are decided as a sum of small searches instead of one product space.
+    if(options.decompose && num_vars >= options.decomposition_min_vars
+       && decomposed_check_if_reachable(system, initial_cubes, options) == 0) {
+        return 0;
     }
 
-    map<int, vector<vector<int>>> func;
-    map<int, vector<int>> tau;
-    for(const auto& [k, funcs] : exploration_functions) {
-        if(find(state_to_explore.begin(), state_to_explore.end(), k) != state_to_explore.end()) {
-            for(const auto& [f, t] : funcs) {
-                vector<int> row;
-                for(int v : state_to_explore) {
-                    row.push_back(f.count(v) ? f.at(v) : 0);
-                }
-                func[k].push_back(row);
-                tau[k].push_back(t);
-            }
+    if(num_vars > options.symbolic_threshold || !fits_in_memory) {
+        cout << "state_to_explore: " << num_vars << " (symbolic)" << endl;
+        double unreachable = symbolic_count_unreachable_states(system, initial_cubes,
+                                                               options.symbolic_node_limit);
+        if(unreachable < 0 && !options.scratch_directory.empty() && !budget_exhausted(BudgetPhase::Inclusion)) {
+            cout << "state_to_explore: " << num_vars << " (out of core)" << endl;
+            long long out_of_core = count_unreachable_states_out_of_core(system, initial_cubes, options);
+            return static_cast<int>(min<long long>(out_of_core, numeric_limits<int>::max()));
         }
+        if(unreachable < 0) return -1;
+        return static_cast<int>(min(unreachable, static_cast<double>(numeric_limits<int>::max())));
     }
 
-    queue<vector<int>> exploration_queue;
-    map<vector<int>, bool> exploration_states;
-    auto all_combos = generate_combinations(state_to_explore.size());
-    for(const auto& combo : all_combos) {
-        exploration_states[combo] = false;
+    int threads = options.threads > 0 ? options.threads : static_cast<int>(thread::hardware_concurrency());
+    // Out of inclusion budget: abandoned like a max_states overrun
+    auto out_of_budget = [] { return budget_exhausted(BudgetPhase::Inclusion); };
+    long long unreachable;
+    if(threads > 1 && num_vars >= options.parallel_min_vars) {
+        unreachable = count_unreachable_states_parallel(system, initial_cubes, threads, 0, out_of_budget);
+    } else {
+        unreachable = count_unreachable_states_batched(system, initial_cubes, 0, out_of_budget);
     }
-
-    int reachable_states = 0;
-    for(const auto& s : included_solutions) {
-        auto states = get_included_solutions_states(s, state_to_explore);
-        for(const auto& state : states) {
-            exploration_queue.push(state);
-            exploration_states[state] = true;
-            reachable_states++;
-        }
+    // Explicit kernels visit every state that reaches the included spaces
+    if(unreachable >= 0) {
+        AILP_TRACE_ARG(scope, "states_visited", (1LL << num_vars) - unreachable);
+        AILP_TRACE_COUNT("reachability.states_visited", (1LL << num_vars) - unreachable);
     }
+    return static_cast<int>(min<long long>(unreachable, numeric_limits<int>::max()));
+}
 
-    while(!exploration_queue.empty()) {
-        auto state = exploration_queue.front();
-        exploration_queue.pop();
-
-        // Generate neighbor states
-        vector<vector<int>> neighbors;
-        for(size_t i=0; i<state.size(); ++i) {
-            auto neighbor = state;
-            neighbor[i] = 1 - neighbor[i];
-            neighbors.push_back(neighbor);
+ThresholdCSR build_threshold_csr(const BooleanNetwork& network,
+                                 const map<int, int>& stable_nodes,
+                                 const vector<int>& external,
+                                 pmr::memory_resource* memory) {
+    ThresholdCSR csr(memory);
+    pmr::vector<int> slot_of(network.state_size, -1, memory);
+    for(int k=0; k<network.state_size; ++k) {
+        if(!stable_nodes.count(k) && network.threshold_functions.count(k)) {
+            slot_of[k] = csr.node_ids.size();
+            csr.node_ids.push_back(k);
         }
-
-        // Check reachability
-        for(auto& neighbor : neighbors) {
-            bool valid = true;
-            for(size_t i=0; i<state_to_explore.size(); ++i) {
-                int k = state_to_explore[i];
-                int sum = inner_product(
-                    func[k].begin(), func[k].end(),
-                    neighbor.begin(), 0
-                );
-                if(sum < tau[k][i]) {
-                    valid = false;
-                    break;
+    }
+    csr.alive.assign(csr.node_ids.size(), 1);
+    csr.row_begin.push_back(0);
+    csr.entry_begin.push_back(0);
+
+    // Stable parents and external inputs are folded into the threshold in the same pass
+    // that copies the remaining weights.
+    for(int k : csr.node_ids) {
+        for(const auto& [weights, threshold] : network.threshold_functions.at(k)) {
+            int t = threshold;
+            for(size_t i=0; i<weights.size(); ++i) {
+                int w = weights[i];
+                if(w == 0) continue;
+                int id = i;
+                if(id < network.state_size) {
+                    auto it = stable_nodes.find(id);
+                    if(it != stable_nodes.end()) {
+                        t -= it->second * w;
+                    } else if(slot_of[id] != -1) {
+                        csr.columns.push_back(slot_of[id]);
+                        csr.weights.push_back(w);
+                    }
+                } else {
+                    size_t ext_idx = id - network.state_size;
+                    if(ext_idx < external.size()) t -= external[ext_idx] * w;
                 }
             }
-
-            if(valid && !exploration_states[neighbor]) {
-                exploration_states[neighbor] = true;
-                exploration_queue.push(neighbor);
-                reachable_states++;
-            }
+            csr.thresholds.push_back(t);
+            csr.entry_begin.push_back(csr.columns.size());
         }
-
-        if(reachable_states == pow(2, state_to_explore.size())) break;
-    }
-
-    if(reachable_states < all_combos.size())
-    {
-        return exploration_states.size() - reachable_states;
+        csr.row_begin.push_back(csr.thresholds.size());
     }
-    return 0;
+    return csr;
 }
 
-// Similar implementations for get_reduced_threshold_functions and get_trivial_nodes
-// would follow the same patterns using STL containers and algorithms
-
-map<int, vector<map<int, int>>> get_trivial_nodes(const map<int, vector<map<int, int>>>& f) {
-    // Create node-to-parents mapping
-    map<int, set<int>> node_to_parents;
-    for (const auto& [k, val] : f) {
-        set<int> parents;
-        for (const auto& func : val) {
-            for (const auto& [p, _] : func) {
-                parents.insert(p);
+void remove_trivial_nodes(ThresholdCSR& csr) {
+    const int n = csr.node_ids.size();
+    // The inner vectors inherit the arena of the outer ones
+    pmr::vector<pmr::vector<int>> parents(n, csr.node_ids.get_allocator());
+    pmr::vector<pmr::vector<int>> children(n, csr.node_ids.get_allocator());
+    for(int k=0; k<n; ++k) {
+        for(int r = csr.row_begin[k]; r < csr.row_begin[k + 1]; ++r) {
+            for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+                parents[k].push_back(csr.columns[e]);
             }
         }
-        node_to_parents[k] = parents;
+        sort(parents[k].begin(), parents[k].end());
+        parents[k].erase(unique(parents[k].begin(), parents[k].end()), parents[k].end());
+        for(int p : parents[k]) children[p].push_back(k);
     }
 
-    // Create node-to-children mapping
-    map<int, vector<int>> node_to_children;
-    for (const auto& [k, _] : f) {
-        node_to_children[k] = vector<int>();
-    }
-    for (const auto& [k, parents] : node_to_parents) {
-        for (int parent : parents) {
-            node_to_children[parent].push_back(k);
+    auto erase_value = [](pmr::vector<int>& v, int x) { v.erase(remove(v.begin(), v.end(), x), v.end()); };
+
+    // Weight of `parent` in the single row of `node`, 0 when absent.
+    auto single_row_weight = [&csr](int node, int parent) {
+        int r = csr.row_begin[node];
+        for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+            if(csr.columns[e] == parent) return csr.weights[e];
         }
-    }
+        return 0;
+    };
 
-    map<int, vector<map<int, int>>> new_f = f;
     bool updated = true;
-
-    while (updated) {
+    while(updated) {
         updated = false;
-        list<int> nodes_to_process;
-        for (const auto& [node_id, _] : node_to_children) {
-            nodes_to_process.push_back(node_id);
-        }
+        for(int k=0; k<n; ++k) {
+            if(!csr.alive[k] || children[k].size() > 1) continue;
 
-        for (int node_id : nodes_to_process) {
-            if (!node_to_children.count(node_id)) continue;
-
-            auto& children = node_to_children[node_id];
-
-            if (children.size() > 1) continue;
-
-            if (children.empty()) {
-                // Remove node with no children
+            if(children[k].empty()) {
+                // Nothing downstream depends on k.
                 updated = true;
-                node_to_children.erase(node_id);
-                new_f.erase(node_id);
-
-                if (node_to_parents.count(node_id)) {
-                    auto parents = node_to_parents[node_id];
-                    node_to_parents.erase(node_id);
-                    for (int parent : parents) {
-                        auto& parent_children = node_to_children[parent];
-                        parent_children.erase(
-                            remove(parent_children.begin(), parent_children.end(), node_id),
-                            parent_children.end()
-                        );
-                    }
-                }
+                csr.alive[k] = 0;
+                for(int p : parents[k]) erase_value(children[p], k);
+                parents[k].clear();
+                continue;
             }
-            else if (node_to_parents.count(node_id) && node_to_parents[node_id].size() == 1) {
-                // Check if we can merge nodes
-                int parent = *node_to_parents[node_id].begin();
-                int child = children[0];
-
-                if (find(node_to_children[parent].begin(), node_to_children[parent].end(), node_id)
-                    == node_to_children[parent].end()) {
-                    continue;
-                }
 
-                // Check weights (simplified check)
-                bool sufficient_weight = true;
-                if (!new_f[node_id].empty() && new_f[node_id][0].count(parent)) {
-                    if (new_f[node_id][0][parent] < 1) sufficient_weight = false;
-                }
-                if (!new_f[child].empty() && new_f[child][0].count(node_id)) {
-                    if (new_f[child][0][node_id] < 1) sufficient_weight = false;
+            if(parents[k].size() != 1) continue;
+            int parent = parents[k][0];
+            int child = children[k][0];
+            if(parent == k || child == k) continue;
+
+            // k copies its parent (a single row [w * parent >= t] with 0 < t <= w) and feeds
+            // its only child positively: route the child's edge straight from the parent.
+            if(csr.row_begin[k + 1] - csr.row_begin[k] != 1) continue;
+            int w = single_row_weight(k, parent);
+            int t = csr.thresholds[csr.row_begin[k]];
+            if(w < 1 || t < 1 || t > w) continue;
+
+            bool sufficient_weight = true;
+            for(int r = csr.row_begin[child]; r < csr.row_begin[child + 1]; ++r) {
+                for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+                    if(csr.columns[e] == k && csr.weights[e] < 1) sufficient_weight = false;
                 }
+            }
+            if(!sufficient_weight) continue;
 
-                if (sufficient_weight) {
-                    updated = true;
-
-                    // Update parent-child relationships
-                    node_to_children[parent].erase(
-                        remove(node_to_children[parent].begin(), node_to_children[parent].end(), node_id),
-                        node_to_children[parent].end()
-                    );
-                    node_to_children[parent].push_back(child);
-
-                    // Update functions
-                    for (auto& func : new_f[child]) {
-                        if (func.count(node_id)) {
-                            int weight = func[node_id];
-                            func.erase(node_id);
-                            func[parent] += weight;
-                        }
+            updated = true;
+            for(int r = csr.row_begin[child]; r < csr.row_begin[child + 1]; ++r) {
+                int parent_entry = -1;
+                for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+                    if(csr.columns[e] == parent) parent_entry = e;
+                }
+                for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+                    if(csr.columns[e] != k) continue;
+                    if(parent_entry == -1) {
+                        csr.columns[e] = parent;
+                        parent_entry = e;
+                    } else {
+                        csr.weights[parent_entry] += csr.weights[e];
+                        csr.columns[e] = -1;
                     }
-
-                    // Cleanup old node
-                    node_to_children.erase(node_id);
-                    node_to_parents.erase(node_id);
-                    new_f.erase(node_id);
                 }
             }
-        }
-    }
-
-    return new_f;
-}
 
-map<int, vector<pair<map<int, int>, int>>> get_reduced_threshold_functions(
-    BooleanNetwork& network,
-    const map<int, int>& stable_nodes,
-    const vector<int>& external,
-    const vector<TrapSpace>& included_solutions) {
-
-    // Step 1: Filter functions and thresholds
-    map<int, vector<map<int, int>>> functions;
-    map<int, vector<int>> thresholds;
-
-    for (const auto& [k, v] : network.get_threshold_functions()) {
-        if (k < network.state_size && !stable_nodes.count(k)) {
-            vector<map<int, int>> funcs;
-            vector<int> thresh;
-            for (const auto& [f, t] : v) {
-                funcs.push_back(f);
-                thresh.push_back(t);
+            erase_value(children[parent], k);
+            if(find(children[parent].begin(), children[parent].end(), child) == children[parent].end()) {
+                children[parent].push_back(child);
             }
-            functions[k] = funcs;
-            thresholds[k] = thresh;
-        }
-    }
-
-    // Step 2: Calculate default values
-    map<int, vector<int>> default_states_values;
-    for (const auto& [k, funcs] : functions) {
-        vector<int> values;
-        for (const auto& f : funcs) {
-            int sum = 0;
-            for (const auto& [i, weight] : f) {
-                sum += stable_nodes.count(i) ? stable_nodes.at(i) * weight : 0;
+            erase_value(parents[child], k);
+            if(find(parents[child].begin(), parents[child].end(), parent) == parents[child].end()) {
+                parents[child].push_back(parent);
             }
-            values.push_back(sum);
+            csr.alive[k] = 0;
+            parents[k].clear();
+            children[k].clear();
         }
-        default_states_values[k] = values;
     }
+}
 
-    map<int, vector<int>> defaults_external_values;
-    for (const auto& [k, funcs] : functions) {
-        vector<int> values;
-        for (const auto& f : funcs) {
-            int sum = 0;
-            for (const auto& [i, weight] : f) {
-                if (i >= network.state_size) {
-                    int ext_idx = i - network.state_size;
-                    sum += external[ext_idx] * weight;
+vector<int> get_nodes_to_explore(const ThresholdCSR& csr, const pmr::vector<char>& not_included) {
+    const int n = csr.node_ids.size();
+    pmr::memory_resource* memory = csr.node_ids.get_allocator().resource();
+    pmr::vector<char> selected(n, 0, memory);
+    pmr::vector<int> stack(memory);
+
+    auto visit_parents = [&](int k) {
+        for(int r = csr.row_begin[k]; r < csr.row_begin[k + 1]; ++r) {
+            for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+                int p = csr.columns[e];
+                if(p >= 0 && csr.alive[p] && !selected[p]) {
+                    selected[p] = 1;
+                    stack.push_back(p);
                 }
             }
-            values.push_back(sum);
         }
-        defaults_external_values[k] = values;
+    };
+
+    for(int k=0; k<n; ++k) {
+        if(csr.alive[k] && not_included[k]) visit_parents(k);
+    }
+    while(!stack.empty()) {
+        int k = stack.back();
+        stack.pop_back();
+        visit_parents(k);
     }
 
-    // Step 3: Update thresholds
-    map<int, vector<int>> updated_threshold;
-    for (const auto& [k, thresh] : thresholds) {
-        vector<int> new_thresh;
-        for (size_t j = 0; j < thresh.size(); ++j) {
-            new_thresh.push_back(thresh[j]
-                - default_states_values[k][j]
-                - defaults_external_values[k][j]);
-        }
-        updated_threshold[k] = new_thresh;
+    vector<int> slots;
+    for(int k=0; k<n; ++k) {
+        if(selected[k]) slots.push_back(k);
     }
+    cout << "state_to_explore: " << slots.size() << endl;
+    return slots;
+}
 
-    // Step 4: Update functions
-    map<int, vector<map<int, int>>> updated_functions;
-    for (const auto& [k, funcs] : functions) {
-        vector<map<int, int>> new_funcs;
-        for (const auto& f : funcs) {
-            map<int, int> new_f;
-            for (const auto& [i, weight] : f) {
-                if (!stable_nodes.count(i) && i < network.state_size) {
-                    new_f[i] = weight;
-                }
+ExplorationSystem compact_exploration_system(const ThresholdCSR& csr, const vector<int>& slots) {
+    ExplorationSystem system;
+    system.num_vars = slots.size();
+    system.row_begin.reserve(slots.size() + 1);
+    system.row_begin.push_back(0);
+
+    pmr::vector<int> position(csr.node_ids.size(), -1, csr.node_ids.get_allocator().resource());
+    size_t rows = 0;
+    system.node_ids.reserve(slots.size());
+    for(size_t i=0; i<slots.size(); ++i) {
+        position[slots[i]] = i;
+        system.node_ids.push_back(csr.node_ids[slots[i]]);
+        rows += csr.row_begin[slots[i] + 1] - csr.row_begin[slots[i]];
+    }
+    // The output outlives the arena, so it is sized once up front
+    system.weights.assign(rows * system.num_vars, 0);
+    system.thresholds.reserve(rows);
+
+    size_t offset = 0;
+    for(int k : slots) {
+        for(int r = csr.row_begin[k]; r < csr.row_begin[k + 1]; ++r, offset += system.num_vars) {
+            for(int e = csr.entry_begin[r]; e < csr.entry_begin[r + 1]; ++e) {
+                int c = csr.columns[e];
+                if(c >= 0 && position[c] != -1) system.weights[offset + position[c]] += csr.weights[e];
             }
-            new_funcs.push_back(new_f);
+            system.thresholds.push_back(csr.thresholds[r]);
         }
-        updated_functions[k] = new_funcs;
+        system.row_begin.push_back(system.thresholds.size());
     }
 
-    // Step 5: Simplify functions
-    auto new_updated_functions = get_trivial_nodes(updated_functions);
-
-    // Step 6: Combine functions and thresholds
-    map<int, vector<pair<map<int, int>, int>>> updated_thresholds_func;
-    for (const auto& [i, funcs] : new_updated_functions) {
-        vector<pair<map<int, int>, int>> combined;
-        for (size_t j = 0; j < funcs.size(); ++j) {
-            combined.emplace_back(funcs[j], updated_threshold[i][j]);
+    // A node is on iff all of its rows hold, so it is positive (negative) unate in
+    // itself when every row weighs it non-negatively (non-positively).
+    for (int v = 0; v < system.num_vars; ++v) {
+        bool any_positive = false, any_negative = false;
+        for (int r = system.row_begin[v]; r < system.row_begin[v + 1]; ++r) {
+            any_positive |= system.row(r)[v] > 0;
+            any_negative |= system.row(r)[v] < 0;
         }
-        updated_thresholds_func[i] = combined;
+        system.self_unateness.push_back(any_positive && any_negative ? 0 : any_positive ? 1 : any_negative ? -1 : 2);
     }
+    return system;
+}
 
-    // Step 7: Determine nodes to explore
-    set<int> not_included_nodes;
-    for (const auto& s : included_solutions) {
-        for (const auto& [i, _] : s.stable_nodes) {
-            if (!stable_nodes.count(i)) {
-                not_included_nodes.insert(i);
-            }
-        }
-    }
+ExplorationSystem get_reduced_threshold_functions(
+    BooleanNetwork& network,
+    const map<int, int>& stable_nodes,
+    const vector<int>& external,
+    const vector<TrapSpace>& included_solutions,
+    pmr::memory_resource* memory) {
 
-    auto nodes_to_explore = get_nodes_to_explore(network, updated_thresholds_func,
-        set<int>(not_included_nodes.begin(), not_included_nodes.end()));
+    ThresholdCSR csr = build_threshold_csr(network, stable_nodes, external, memory);
+    remove_trivial_nodes(csr);
 
-    // Final filtering
-    map<int, vector<pair<map<int, int>, int>>> result;
-    for (const auto& [i, v] : updated_thresholds_func) {
-        if (find(nodes_to_explore.begin(), nodes_to_explore.end(), i) != nodes_to_explore.end()) {
-            result[i] = v;
+    // Nodes the included solutions fix but this solution leaves free.
+    pmr::vector<int> slot_of(network.state_size, -1, memory);
+    for(size_t k=0; k<csr.node_ids.size(); ++k) slot_of[csr.node_ids[k]] = k;
+    pmr::vector<char> not_included(csr.node_ids.size(), 0, memory);
+    for(const auto& s : included_solutions) {
+        for(const auto& [i, _] : s.stable_nodes) {
+            if(i < network.state_size && slot_of[i] != -1) not_included[slot_of[i]] = 1;
         }
     }
 
-    return result;
+    return compact_exploration_system(csr, get_nodes_to_explore(csr, not_included));
 }
-
-
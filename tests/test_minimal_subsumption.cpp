@@ -0,0 +1,31 @@
+// Minimal mode must not report a space that contains a found one just because an
+// external nobody reads takes another value.
+#include "test_utils.h"
+#include "ILPModelBuilder.h"
+
+using namespace std;
+
+int main()
+{
+    // n0 = n0, n1 = n1; external n2 is read by no node
+    BooleanNetwork network = make_threshold_network(2, 1, {
+        {0, {{{1, 0, 0}, 1}}},
+        {1, {{{0, 1, 0}, 1}}},
+    });
+    PercolationResult percolation;
+    percolation.free_states = {0, 1};
+
+    enumeration_options.minimal_only = true;
+    enumeration_options.use_fvs = false;
+    enumeration_options.decompose_modules = false;
+
+    set<map<int, int>> expected = {
+        {{0, 0}, {1, 0}}, {{0, 0}, {1, 1}}, {{0, 1}, {1, 0}}, {{0, 1}, {1, 1}},
+    };
+    CHECK(as_set(enumerate_trap_spaces(network, percolation, 1)) == expected);
+
+    ILPModel ilp_model = build_ilp_model(network, 2, percolation);
+    CHECK(as_set(enumerate_by_size(ilp_model, 2)) == expected);
+
+    return test_failures;
+}
@@ -0,0 +1,44 @@
+// Solving the modules apart and combining them must give the monolithic trap spaces,
+// including for modules whose self-loops keep them from staying free.
+#include "test_utils.h"
+#include "ILPModelBuilder.h"
+#include "ModularDecomposition.h"
+
+using namespace std;
+
+int main()
+{
+    // n0 = n0, n1 = !n1, n2 = n2 & n3, n3 = n3: only n1 can stay free
+    BooleanNetwork network = make_threshold_network(4, 0, {
+        {0, {{{1, 0, 0, 0}, 1}}},
+        {1, {{{0, -1, 0, 0}, 0}}},
+        {2, {{{0, 0, 1, 0}, 1}, {{0, 0, 0, 1}, 1}}},
+        {3, {{{0, 0, 0, 1}, 1}}},
+    });
+    PercolationResult percolation = get_percolation(network, {});
+    CHECK(get_network_modules(network, percolation).size() > 1);
+
+    for (bool use_fvs : {true, false}) {
+        enumeration_options.use_fvs = use_fvs;
+        enumeration_options.decompose_modules = false;
+        auto monolithic = find_trap_spaces(network, percolation);
+        enumeration_options.decompose_modules = true;
+        auto decomposed = find_trap_spaces(network, percolation);
+
+        CHECK(as_set(decomposed) == as_set(monolithic));
+        CHECK(decomposed.size() == monolithic.size());
+        for (const auto& space : decomposed) {
+            CHECK(space.count(0) && space.count(2) && space.count(3) && !space.count(1));
+        }
+
+        // A sink gets the same spaces and nothing is collected
+        vector<map<int, int>> streamed;
+        auto returned = find_trap_spaces(network, percolation, [&streamed](const map<int, int>& space) {
+            streamed.push_back(space);
+        });
+        CHECK(returned.empty());
+        CHECK(streamed == decomposed);
+    }
+
+    return test_failures;
+}
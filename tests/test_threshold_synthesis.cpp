@@ -0,0 +1,54 @@
+// Threshold synthesis: an OR of two ANDs needs two rows, and a wide parity function,
+// which no few rows express, must still finish through the clause fallback. The rows
+// must reproduce the function on every input.
+#include "test_utils.h"
+#include "Node.h"
+
+using namespace std;
+
+// Whether the AND of the rows holds at the input given by mask (bit i = node i)
+bool rows_hold(const Node& node, int inputs, int mask)
+{
+    for (const auto& [weights, threshold] : node.threshold) {
+        int sum = 0;
+        for (int i = 0; i < inputs; ++i) sum += weights[i] * ((mask >> i) & 1);
+        if (sum < threshold) return false;
+    }
+    return true;
+}
+
+int main()
+{
+    unordered_map<string, int> name_to_id = {{"a", 0}, {"b", 1}, {"c", 2}, {"d", 3}};
+    Node node(4, "f", "(a&b)|(c&d)");
+    node.solveThresholdFunction(4, name_to_id);
+
+    CHECK(node.threshold.size() == 2);
+    for (int mask = 0; mask < 16; ++mask) {
+        bool a = mask & 1, b = mask & 2, c = mask & 4, d = mask & 8;
+        CHECK(rows_hold(node, 4, mask) == ((a && b) || (c && d)));
+    }
+
+    // Odd parity of 9 inputs as the OR of its minterms: one clause per even point
+    const int inputs = 9;
+    unordered_map<string, int> parity_ids;
+    for (int i = 0; i < inputs; ++i) parity_ids["x" + to_string(i)] = i;
+    string expr;
+    for (int mask = 0; mask < (1 << inputs); ++mask) {
+        if (__builtin_popcount(mask) % 2 == 0) continue;
+        string term;
+        for (int i = 0; i < inputs; ++i) {
+            term += (term.empty() ? "" : "&") + string((mask >> i) & 1 ? "" : "~") + "x" + to_string(i);
+        }
+        expr += (expr.empty() ? "(" : "|(") + term + ")";
+    }
+    Node parity(inputs, "p", expr);
+    parity.solveThresholdFunction(inputs, parity_ids);
+
+    CHECK(parity.threshold.size() == (1u << (inputs - 1)));
+    for (int mask = 0; mask < (1 << inputs); ++mask) {
+        CHECK(rows_hold(parity, inputs, mask) == (__builtin_popcount(mask) % 2 == 1));
+    }
+
+    return test_failures;
+}
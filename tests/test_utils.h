@@ -0,0 +1,42 @@
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "BooleanNetwork.h"
+
+// Each test is a plain executable: CHECK reports the failure and the exit code is the
+// number of failed checks.
+inline int test_failures = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            ++test_failures;                                                               \
+        }                                                                                  \
+    } while (0)
+
+// Network given directly by its threshold rows (node id -> rows over state nodes, then
+// externals), without parsing or synthesis.
+inline BooleanNetwork make_threshold_network(int state_size, int external_size,
+                                             const std::map<int, ThresholdFunctions>& functions)
+{
+    BooleanNetwork network;
+    network.state_size = state_size;
+    network.external_size = external_size;
+    for (int i = 0; i < state_size + external_size; ++i) network.index_to_name.push_back("n" + std::to_string(i));
+    for (const auto& [k, rows] : functions) network.threshold_functions[k] = rows;
+    network.compute_unateness();
+    return network;
+}
+
+inline std::set<std::map<int, int>> as_set(const std::vector<std::map<int, int>>& spaces)
+{
+    return std::set<std::map<int, int>>(spaces.begin(), spaces.end());
+}
+
+#endif // TEST_UTILS_H